@@ -0,0 +1,106 @@
+// Microbenchmarks for the firmware's hot functions, compiled natively
+// against the mocked Arduino core. A plain chrono loop instead of a
+// benchmark framework keeps the harness dependency-free beyond
+// ArduinoJson, which the encoders genuinely use.
+//
+// Numbers are host numbers — an order of magnitude off the ESP32's —
+// but they move in the same direction, which is what regression
+// tracking needs. The flash-queue figure in particular measures the
+// record layout and stdio syscalls, not flash latency.
+
+#include <chrono>
+#include <cstdio>
+
+#include "sphinx_config.h"
+#include "sphinx_heat.h"
+#include "sphinx_queue.h"
+#include "sphinx_wire.h"
+#include "sphinx_clock.h"
+
+namespace {
+
+volatile uint32_t gSink; // keeps the optimizer honest
+
+QueuedReading makeReading(uint16_t i) {
+  QueuedReading r;
+  r.humidity = 40.0f + (i % 30);
+  r.tempC = 20.0f + (i % 15);
+  r.tempF = r.tempC * 9.0f / 5.0f + 32.0f;
+  HeatIndex hi = computeHeatIndexBoth(r.tempF, r.humidity);
+  r.heatIndexC = hi.c;
+  r.heatIndexF = hi.f;
+  r.uptime = 1000 + i;
+  r.epoch = 1700000000UL + i;
+  r.probeId = i % 3;
+  return r;
+}
+
+template <typename Fn>
+void run(const char* name, long iterations, Fn fn) {
+  fn(); // warm-up: page in code, open files
+  auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < iterations; i++) {
+    fn();
+  }
+  auto end = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                  .count() /
+              (double)iterations;
+  printf("%-24s %10.1f ns/op  (%ld iterations)\n", name, ns, iterations);
+}
+
+} // namespace
+
+int main() {
+  QueuedReading batch[kBatchSize];
+  for (uint16_t i = 0; i < kBatchSize; i++) {
+    batch[i] = makeReading(i);
+  }
+
+  const char* probeIDs[kMaxProbes];
+  char idStorage[kMaxProbes][24];
+  for (uint8_t i = 0; i < kMaxProbes; i++) {
+    snprintf(idStorage[i], sizeof(idStorage[i]), "A0B1C2D3E4F5-%u", i);
+    probeIDs[i] = idStorage[i];
+  }
+
+  static char jsonBuffer[kJsonBatchBufferSize];
+  static uint8_t binaryBuffer[kBinaryBatchBufferSize];
+  const uint8_t mac[6] = {0xA0, 0xB1, 0xC2, 0xD3, 0xE4, 0xF5};
+
+  run("json_batch", 20000, [&] {
+    gSink += buildJsonBatch(batch, kBatchSize, probeIDs, jsonBuffer,
+                            sizeof(jsonBuffer));
+  });
+
+  run("json_reading", 100000, [&] {
+    gSink += buildJsonReading(batch[0], probeIDs[0], jsonBuffer,
+                              sizeof(jsonBuffer));
+  });
+
+  run("binary_batch", 200000, [&] {
+    gSink += encodeBinaryBatch(batch, kBatchSize, mac, binaryBuffer);
+  });
+
+  FlashQueue queue;
+  queue.begin();
+  run("flash_queue_push", 20000, [&] {
+    queue.push(batch[0]);
+  });
+
+  run("format_uptime", 200000, [&] {
+    gSink += formatUptime(1234567UL).length();
+  });
+
+  char ts[32];
+  run("format_epoch", 200000, [&] {
+    NtpClock::formatEpoch(1700000000UL, ts, sizeof(ts));
+    gSink += ts[0];
+  });
+
+  run("heat_index", 1000000, [&] {
+    gSink += (uint32_t)computeHeatIndexBoth(88.0f, 70.0f).c;
+  });
+
+  return 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// Host-side stand-in for the Arduino core: just enough surface for the
+// hardware-independent parts of sphinx_core (config, heat index, flash
+// queue, wire encoders, clock math, backoff) to compile natively on
+// Linux. Time is simulated — the soak test advances it explicitly — so
+// 72 hours of loop iterations replay in seconds.
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+using std::max;
+using std::min;
+
+// Simulated millis(): starts at 0, advanced by the harness.
+unsigned long millis();
+void sphinxMockAdvanceMillis(unsigned long ms);
+
+// FreeRTOS mutex surface (the target gets these through Arduino.h too).
+// The harness is single-threaded, so they are no-ops.
+typedef void* SemaphoreHandle_t;
+#define portMAX_DELAY 0xFFFFFFFFUL
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return (SemaphoreHandle_t)1; }
+inline int xSemaphoreTake(SemaphoreHandle_t, unsigned long) { return 1; }
+inline int xSemaphoreGive(SemaphoreHandle_t) { return 1; }
+
+// Thin veneer over std::string with the Arduino spelling the core uses.
+class String : public std::string {
+ public:
+  String() {}
+  String(const char* s) : std::string(s ? s : "") {}
+  String(const std::string& s) : std::string(s) {}
+  unsigned int length() const { return (unsigned int)size(); }
+};
+
+// Swallows all output; the benchmarks measure encoders, not printf.
+class MockSerial {
+ public:
+  template <typename T>
+  void print(const T&) {}
+  template <typename T>
+  void println(const T&) {}
+  void println() {}
+};
+
+extern MockSerial Serial;
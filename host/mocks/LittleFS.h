@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+
+#include "Arduino.h"
+
+// LittleFS stand-in on POSIX stdio. Flash paths like "/readings.bin"
+// map into the working directory so the ring file lands next to the
+// binary, not in the host's root. Mode strings ("r", "w", "r+") are the
+// same ones fopen takes, so they pass straight through.
+class File {
+ public:
+  File() : f_(NULL) {}
+  explicit File(FILE* f) : f_(f) {}
+
+  operator bool() const { return f_ != NULL; }
+
+  size_t size() {
+    long pos = ftell(f_);
+    fseek(f_, 0, SEEK_END);
+    long end = ftell(f_);
+    fseek(f_, pos, SEEK_SET);
+    return end < 0 ? 0 : (size_t)end;
+  }
+
+  size_t read(uint8_t* buf, size_t len) { return fread(buf, 1, len, f_); }
+  size_t write(const uint8_t* buf, size_t len) { return fwrite(buf, 1, len, f_); }
+  bool seek(size_t pos) { return fseek(f_, (long)pos, SEEK_SET) == 0; }
+
+  void close() {
+    if (f_ != NULL) {
+      fclose(f_);
+      f_ = NULL;
+    }
+  }
+
+ private:
+  FILE* f_;
+};
+
+class LittleFSImpl {
+ public:
+  bool begin(bool) { return true; }
+
+  File open(const char* path, const char* mode) {
+    std::string hostPath = ".";
+    hostPath += path;
+    return File(fopen(hostPath.c_str(), mode));
+  }
+};
+
+extern LittleFSImpl LittleFS;
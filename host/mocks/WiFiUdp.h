@@ -0,0 +1,5 @@
+#pragma once
+
+// The clock's UDP socket never opens on the host; NTPClient below is
+// stubbed to answer from simulated time.
+class WiFiUDP {};
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// Hardware RNG stand-in; the backoff jitter doesn't need entropy on the
+// host, just spread.
+inline uint32_t esp_random() { return (uint32_t)rand(); }
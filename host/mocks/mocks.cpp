@@ -0,0 +1,10 @@
+#include "Arduino.h"
+#include "LittleFS.h"
+
+static unsigned long gMillis = 0;
+
+unsigned long millis() { return gMillis; }
+void sphinxMockAdvanceMillis(unsigned long ms) { gMillis += ms; }
+
+MockSerial Serial;
+LittleFSImpl LittleFS;
@@ -0,0 +1,108 @@
+// Replays 72 hours of the sampling/report pipeline in simulated time and
+// fails if the heap grows. The report path is built on static buffers,
+// so once the ring file and stdio are warm, allocated bytes must stay
+// flat — any growth here is a leak or a new per-iteration allocation
+// that would eventually kill a node in the field.
+
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "sphinx_config.h"
+#include "sphinx_heat.h"
+#include "sphinx_queue.h"
+#include "sphinx_wire.h"
+#include "sphinx_clock.h"
+
+namespace {
+
+long long heapInUse() {
+#if defined(__GLIBC__)
+  struct mallinfo2 mi = mallinfo2();
+  return (long long)mi.uordblks;
+#else
+  return 0; // growth check becomes a no-op off glibc
+#endif
+}
+
+} // namespace
+
+int main() {
+  const unsigned long kSampleIntervalMs = 2000;
+  const long kIterations = 72L * 3600L * 1000L / kSampleIntervalMs; // 129600
+
+  NtpClock clock;
+  clock.begin();
+
+  FlashQueue queue;
+  queue.begin();
+
+  const char* probeIDs[kMaxProbes];
+  char idStorage[kMaxProbes][24];
+  for (uint8_t i = 0; i < kMaxProbes; i++) {
+    snprintf(idStorage[i], sizeof(idStorage[i]), "A0B1C2D3E4F5-%u", i);
+    probeIDs[i] = idStorage[i];
+  }
+
+  static char jsonBuffer[kJsonBatchBufferSize];
+  static QueuedReading batch[kBatchSize];
+  long long baseline = 0;
+  long batchesSent = 0;
+
+  for (long i = 0; i < kIterations; i++) {
+    sphinxMockAdvanceMillis(kSampleIntervalMs);
+    clock.update();
+
+    // One sampling pass, as sampleAndQueueReading() does it.
+    QueuedReading reading;
+    reading.humidity = 40.0f + (i % 300) * 0.1f;
+    reading.tempC = 18.0f + (i % 120) * 0.1f;
+    reading.tempF = reading.tempC * 9.0f / 5.0f + 32.0f;
+    HeatIndex hi = computeHeatIndexBoth(reading.tempF, reading.humidity);
+    reading.heatIndexC = hi.c;
+    reading.heatIndexF = hi.f;
+    reading.uptime = millis() / 1000;
+    reading.epoch = clock.epochNow();
+    reading.probeId = (uint8_t)(i % 3);
+    queue.push(reading);
+
+    // Drain pass: encode and "send" a full batch.
+    if (queue.count() >= kBatchSize) {
+      uint16_t count = queue.peekMany(batch, kBatchSize);
+      buildJsonBatch(batch, count, probeIDs, jsonBuffer, sizeof(jsonBuffer));
+      queue.popMany(count);
+      batchesSent++;
+    }
+
+    // Status page / uptime formatting runs too; it returns a String and
+    // must not leave anything behind.
+    if (i % 30 == 0) {
+      formatUptime(millis() / 1000);
+    }
+
+    // Baseline after 10% of the run, once every lazy init has happened.
+    if (i == kIterations / 10) {
+      baseline = heapInUse();
+    }
+  }
+
+  long long finalUse = heapInUse();
+  long long growth = finalUse - baseline;
+  printf("Soak: %ld iterations (72 h simulated), %ld batches encoded\n",
+         kIterations, batchesSent);
+  printf("Heap in use: baseline %lld B, final %lld B, growth %lld B\n",
+         baseline, finalUse, growth);
+
+  // Allow a little stdio/allocator slack; real leaks compound over
+  // 129600 iterations and blow straight past this.
+  const long long kAllowedGrowthBytes = 16 * 1024;
+  if (growth > kAllowedGrowthBytes) {
+    printf("FAIL: heap grew by %lld B over the soak window\n", growth);
+    return 1;
+  }
+  printf("PASS\n");
+  return 0;
+}
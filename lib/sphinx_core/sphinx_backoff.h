@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+#include "esp_system.h"
+
+// Jittered exponential backoff for reconnect/retry scheduling. Each
+// dependency (link, NTP, tokens, API POSTs) keeps its own instance, so
+// one failing service never gates the others, and the ±25% jitter keeps
+// hundreds of nodes that lost the same uplink from hammering the ingest
+// server in lockstep when it comes back.
+class Backoff {
+ public:
+  Backoff(unsigned long minDelayMs, unsigned long maxDelayMs)
+      : minDelayMs_(minDelayMs), maxDelayMs_(maxDelayMs), delayMs_(minDelayMs) {}
+
+  // True when the next attempt may run; fresh instances are due
+  // immediately. The signed comparison survives millis() wrap.
+  bool due() const { return (long)(millis() - nextAttemptMs_) >= 0; }
+
+  void recordFailure() {
+    unsigned long jitter = delayMs_ / 4;
+    nextAttemptMs_ = millis() + delayMs_ - jitter + esp_random() % (2 * jitter + 1);
+    delayMs_ = min(delayMs_ * 2, maxDelayMs_);
+  }
+
+  void reset() {
+    delayMs_ = minDelayMs_;
+    nextAttemptMs_ = millis();
+  }
+
+ private:
+  unsigned long minDelayMs_;
+  unsigned long maxDelayMs_;
+  unsigned long delayMs_;
+  unsigned long nextAttemptMs_ = 0;
+};
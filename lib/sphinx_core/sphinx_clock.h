@@ -0,0 +1,93 @@
+#pragma once
+
+#include <Arduino.h>
+#include <NTPClient.h>
+#include <WiFiUdp.h>
+#include <time.h>
+
+#include "sphinx_backoff.h"
+#include "sphinx_config.h"
+
+// Monotonic wall clock: one NTP exchange per hour establishes an
+// epoch/millis base pair, and every timestamp in between is a 32-bit add
+// on top of millis(). This removes the old per-loop NTPClient traffic
+// and the per-reading strftime from the hot path; payloads carry the
+// epoch integer directly.
+class NtpClock {
+ public:
+  NtpClock() : ntp_(udp_, "pool.ntp.org") {}
+
+  void begin() {
+    ntp_.begin();
+    resync();
+  }
+
+  // Scheduler job: cheap no-op until the hourly resync is due. A failed
+  // sync (NTP unreachable) retries on a jittered backoff from one minute
+  // up to fifteen, instead of waiting the full hour with a drifting
+  // clock — or hammering the pool once a minute through a long outage.
+  void update() {
+    if (synced_ && millis() - lastSyncMillis_ < kResyncIntervalMs) {
+      return;
+    }
+    if (!retryBackoff_.due()) {
+      return;
+    }
+    if (resync()) {
+      retryBackoff_.reset();
+    } else {
+      retryBackoff_.recordFailure();
+    }
+  }
+
+  bool forceUpdate() { return resync(); }
+
+  uint32_t epochNow() const {
+    return epochBase_ + (millis() - millisBase_) / 1000;
+  }
+
+  bool synced() const { return synced_; }
+
+  static void formatEpoch(uint32_t epoch, char* out, size_t outSize) {
+    time_t now = epoch;
+    struct tm timeinfo;
+    gmtime_r(&now, &timeinfo);
+    strftime(out, outSize, "%Y-%m-%dT%H:%M:%SZ", &timeinfo);
+  }
+
+ private:
+  static const unsigned long kResyncIntervalMs = 3600000; // once per hour
+
+  bool resync() {
+    if (!ntp_.forceUpdate()) {
+      return false;
+    }
+    epochBase_ = ntp_.getEpochTime();
+    millisBase_ = millis();
+    lastSyncMillis_ = millis();
+    synced_ = true;
+    return true;
+  }
+
+  WiFiUDP udp_;
+  NTPClient ntp_;
+  Backoff retryBackoff_{60000, 900000};
+  uint32_t epochBase_ = 0;
+  unsigned long millisBase_ = 0;
+  unsigned long lastSyncMillis_ = 0;
+  bool synced_ = false;
+};
+
+String formatUptime(unsigned long uptimeSeconds) {
+  unsigned long days = uptimeSeconds / 86400;
+  uptimeSeconds %= 86400;
+  unsigned long hours = uptimeSeconds / 3600;
+  uptimeSeconds %= 3600;
+  unsigned long minutes = uptimeSeconds / 60;
+  unsigned long seconds = uptimeSeconds % 60;
+
+  char uptimeBuffer[20];
+  snprintf(uptimeBuffer, sizeof(uptimeBuffer), "%lu days %02lu:%02lu:%02lu", days, hours, minutes, seconds);
+
+  return String(uptimeBuffer);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Compile-time sizing shared across the core. Batch size doubles as the
+// static buffer dimension in the wire encoders, so it stays a constant
+// rather than a config field.
+const uint16_t kBatchSize = 15;
+const unsigned long kMaxBatchDelayMs = 30000;
+const uint16_t kReadingQueueCapacity = 1200; // ~40 minutes of samples at 2 s
+const uint8_t kMaxProbes = 8;
+
+// Reported in OTA manifest checks; bump with each fleet release.
+static const char kFirmwareVersion[] = "1.0.0";
+
+// One physical probe on the node. The logical ID (0..kMaxProbes-1)
+// identifies the probe on the wire under the node's MAC: sub-ID 0 is
+// reported as the bare MAC — so single-probe nodes keep their historical
+// sensor_id — and nonzero sub-IDs as "<MAC>-<id>".
+struct ProbeConfig {
+  uint8_t pin;
+  uint8_t type; // DHT11 / DHT22
+  uint8_t id;
+};
+
+// Per-board settings; each sketch fills one of these and hands it to
+// SensorNode. Everything that used to be a #define or a top-of-file
+// constant in the copy-pasted sketches lives here instead.
+struct NodeConfig {
+  // Network credentials (WiFi transports only)
+  const char* ssid;
+  const char* password;
+
+  // Ingest endpoints
+  const char* apiEndpoint;
+  const char* bulkApiEndpoint;
+  const char* tokenEndpoint;
+  const char* refreshEndpoint;
+
+  // Local web UI credentials
+  const char* basicAuthUsername;
+  const char* basicAuthPassword;
+
+  // API credentials used by obtainTokens()
+  const char* apiUsername;
+  const char* apiPassword;
+
+  // Wiring
+  uint8_t dhtPin;
+  uint8_t dhtType;
+  uint8_t ledPin;
+  uint8_t resetButtonPin;
+
+  uint32_t serialBaud;
+  unsigned long sampleIntervalMs;
+
+  // Deep-sleep telemetry mode (battery nodes)
+  uint32_t lowPowerWakeIntervalSec;
+  uint32_t uploadEveryNthWake;
+
+  // Optional probe table for multi-probe nodes (rack builds with
+  // intake/exhaust probes per U-zone). Left unset, the node runs the
+  // single dhtPin/dhtType probe as sub-ID 0.
+  const ProbeConfig* probes;
+  uint8_t probeCount;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+// Umbrella header for the shared Sphinx sensor firmware core. Sketches
+// include this plus their transport header (sphinx_wifi.h or
+// sphinx_eth.h — kept out of the umbrella so the Ethernet build never
+// pulls in the WiFi manager), fill in a NodeConfig and instantiate
+// SensorNode with the transport.
+
+#include "sphinx_config.h"
+#include "sphinx_backoff.h"
+#include "sphinx_settings.h"
+#include "sphinx_clock.h"
+#include "sphinx_heat.h"
+#include "sphinx_queue.h"
+#include "sphinx_wire.h"
+#include "sphinx_net.h"
+#include "sphinx_raw.h"
+#include "sphinx_mqtt.h"
+#include "sphinx_ota.h"
+#include "sphinx_stats.h"
+#include "sphinx_wdt.h"
+#include "sphinx_node.h"
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ETH.h>
+
+#include "sphinx_config.h"
+
+// Wired transport for rack-mounted nodes: ESP32 RMII MAC with a LAN8720
+// PHY. No scan, no DHCP-over-radio stall, no 2.4 GHz jitter — and
+// because Transport is a compile-time parameter, builds using this
+// transport link none of the WiFi manager code.
+//
+// Pinout for the common LAN8720 breakout: MDC on GPIO23, MDIO on GPIO18,
+// 50 MHz clock from the PHY's oscillator into GPIO0, no power-enable pin.
+#ifndef SPHINX_ETH_PHY_ADDR
+#define SPHINX_ETH_PHY_ADDR 1
+#endif
+#ifndef SPHINX_ETH_PHY_POWER
+#define SPHINX_ETH_PHY_POWER -1
+#endif
+#ifndef SPHINX_ETH_PHY_MDC
+#define SPHINX_ETH_PHY_MDC 23
+#endif
+#ifndef SPHINX_ETH_PHY_MDIO
+#define SPHINX_ETH_PHY_MDIO 18
+#endif
+#ifndef SPHINX_ETH_CLK_MODE
+#define SPHINX_ETH_CLK_MODE ETH_CLOCK_GPIO0_IN
+#endif
+
+class EthTransport {
+ public:
+  void begin(const NodeConfig& config) {
+    Serial.println("Bringing up LAN8720 Ethernet");
+
+    ETH.begin(SPHINX_ETH_PHY_ADDR, SPHINX_ETH_PHY_POWER, SPHINX_ETH_PHY_MDC,
+              SPHINX_ETH_PHY_MDIO, ETH_PHY_LAN8720, SPHINX_ETH_CLK_MODE);
+
+    // Wired link-up plus DHCP is normally well under a second. A dead
+    // cable or switch port is the link job's problem — the MAC renegotiates
+    // on its own once the link returns, so there is nothing to kick here.
+    if (!waitForLink(5000)) {
+      Serial.println("Ethernet link down; continuing, link recovers on its own");
+      return;
+    }
+
+    Serial.println("Ethernet connected.");
+    Serial.println("IP address: ");
+    Serial.println(ETH.localIP());
+  }
+
+  // The RMII MAC re-associates by itself when the cable comes back;
+  // these exist so the node's link job can treat all transports alike.
+  void kickReconnect() {}
+  void noteConnected() {}
+
+  bool beginBounded(const NodeConfig& config, unsigned long timeoutMs) {
+    ETH.begin(SPHINX_ETH_PHY_ADDR, SPHINX_ETH_PHY_POWER, SPHINX_ETH_PHY_MDC,
+              SPHINX_ETH_PHY_MDIO, ETH_PHY_LAN8720, SPHINX_ETH_CLK_MODE);
+    return waitForLink(timeoutMs);
+  }
+
+  bool connected() const {
+    return ETH.linkUp() && (uint32_t)ETH.localIP() != 0;
+  }
+
+  String macAddress() const { return ETH.macAddress(); }
+
+  void macAddressBytes(uint8_t out[6]) const { ETH.macAddress(out); }
+
+  IPAddress localIP() const { return ETH.localIP(); }
+
+  void powerOff() {}
+
+ private:
+  bool waitForLink(unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (!connected()) {
+      if (millis() - start >= timeoutMs) {
+        return false;
+      }
+      delay(100);
+      Serial.print(".");
+    }
+    Serial.println("");
+    return true;
+  }
+};
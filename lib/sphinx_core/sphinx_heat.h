@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Heat index in pure single-precision. The DHT library runs the 9-term
+// Rothfusz regression in double — which the ESP32's single-precision
+// FPU can't execute, so every call traps into soft-float emulation —
+// and the old loop paid for it twice per cycle (once per unit). This
+// evaluates the regression once in float, in Fahrenheit like the NWS
+// reference, and derives Celsius from the result. Callers cache the
+// pair in the reading struct; nothing downstream recomputes it.
+struct HeatIndex {
+  float c;
+  float f;
+};
+
+inline HeatIndex computeHeatIndexBoth(float tempF, float humidity) {
+  // Steadman's simple formula, switching to the full Rothfusz
+  // regression with its low/high-humidity corrections when the simple
+  // result crosses 79 °F — same decision the NWS algorithm makes.
+  float hi = 0.5f * (tempF + 61.0f + ((tempF - 68.0f) * 1.2f) + (humidity * 0.094f));
+
+  if (hi > 79.0f) {
+    hi = -42.379f +
+         2.04901523f * tempF +
+         10.14333127f * humidity +
+         -0.22475541f * tempF * humidity +
+         -0.00683783f * tempF * tempF +
+         -0.05481717f * humidity * humidity +
+         0.00122874f * tempF * tempF * humidity +
+         0.00085282f * tempF * humidity * humidity +
+         -0.00000199f * tempF * tempF * humidity * humidity;
+
+    if (humidity < 13.0f && tempF >= 80.0f && tempF <= 112.0f) {
+      hi -= ((13.0f - humidity) * 0.25f) *
+            sqrtf((17.0f - fabsf(tempF - 95.0f)) * 0.05882f);
+    } else if (humidity > 85.0f && tempF >= 80.0f && tempF <= 87.0f) {
+      hi += ((humidity - 85.0f) * 0.1f) * ((87.0f - tempF) * 0.2f);
+    }
+  }
+
+  HeatIndex out;
+  out.f = hi;
+  out.c = (hi - 32.0f) * (5.0f / 9.0f);
+  return out;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <Arduino.h>
+#include "mqtt_client.h"
+
+#include "sphinx_queue.h"
+#include "sphinx_wire.h"
+
+// MQTT reporting on ESP-IDF's esp_mqtt_client (same layer as the
+// esp_http_client HTTPS session, and the only stack here that does real
+// QoS 1). One reading becomes a ~40-byte publish on an always-open
+// connection instead of an HTTPS exchange:
+//
+//   sphinx/<MAC>/readings   one JSON reading per publish, QoS 1
+//   sphinx/<MAC>/status     retained "online"/"offline"; "offline" is the
+//                           broker's last-will, so down-detection is the
+//                           keepalive interval instead of the server
+//                           inferring staleness from last_update
+//
+// The session is persistent (clean_session off) and the flash ring stays
+// the in-flight store: a reading is only popped once the broker has
+// acknowledged its publish, so broker outages cost flash space, not data.
+class MqttReporter {
+ public:
+  void begin(const String& brokerUri, const String& nodeId) {
+    brokerUri_ = brokerUri;
+    nodeId_ = nodeId;
+    snprintf(readingsTopic_, sizeof(readingsTopic_), "sphinx/%s/readings", nodeId_.c_str());
+    snprintf(statusTopic_, sizeof(statusTopic_), "sphinx/%s/status", nodeId_.c_str());
+
+    esp_mqtt_client_config_t config = {};
+    config.uri = brokerUri_.c_str();
+    config.client_id = nodeId_.c_str();
+    config.keepalive = 15; // seconds; bounds how long "online" can be stale
+    config.disable_clean_session = true;
+    config.lwt_topic = statusTopic_;
+    config.lwt_msg = "offline";
+    config.lwt_qos = 1;
+    config.lwt_retain = 1;
+
+    client_ = esp_mqtt_client_init(&config);
+    if (client_ == NULL) {
+      Serial.println("MQTT: client init failed");
+      return;
+    }
+    esp_mqtt_client_register_event(client_, (esp_mqtt_event_id_t)ESP_EVENT_ANY_ID,
+                                   eventHandler, this);
+    esp_mqtt_client_start(client_);
+  }
+
+  bool enabled() const { return client_ != NULL; }
+
+  bool connected() const { return connected_; }
+
+  // QoS 1 publish of one reading; blocks (on the network task) until the
+  // broker acks or the timeout passes. Returning false leaves the
+  // reading in the flash ring for the next drain pass.
+  bool publishReading(const char* sensorID, const QueuedReading& reading) {
+    if (!connected_) {
+      return false;
+    }
+    char payload[192];
+    buildJsonReading(reading, sensorID, payload, sizeof(payload));
+
+    int msgId = esp_mqtt_client_publish(client_, readingsTopic_, payload, 0, 1, 0);
+    if (msgId < 0) {
+      return false;
+    }
+    return waitForAck(msgId, 2000);
+  }
+
+ private:
+  bool waitForAck(int msgId, unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (lastAckedMsgId_ != msgId) {
+      if (millis() - start >= timeoutMs) {
+        Serial.println("MQTT: publish ack timed out");
+        return false;
+      }
+      vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return true;
+  }
+
+  static void eventHandler(void* arg, esp_event_base_t, int32_t eventId, void* eventData) {
+    MqttReporter* self = (MqttReporter*)arg;
+    esp_mqtt_event_handle_t event = (esp_mqtt_event_handle_t)eventData;
+    switch ((esp_mqtt_event_id_t)eventId) {
+      case MQTT_EVENT_CONNECTED:
+        self->connected_ = true;
+        // Overwrite the retained last-will from any previous death.
+        esp_mqtt_client_publish(self->client_, self->statusTopic_, "online", 0, 1, 1);
+        Serial.println("MQTT: connected");
+        break;
+      case MQTT_EVENT_DISCONNECTED:
+        self->connected_ = false;
+        Serial.println("MQTT: disconnected");
+        break;
+      case MQTT_EVENT_PUBLISHED:
+        self->lastAckedMsgId_ = event->msg_id;
+        break;
+      default:
+        break;
+    }
+  }
+
+  String brokerUri_;
+  String nodeId_;
+  char readingsTopic_[48];
+  char statusTopic_[48];
+  esp_mqtt_client_handle_t client_ = NULL;
+  volatile bool connected_ = false;
+  volatile int lastAckedMsgId_ = -1;
+};
@@ -0,0 +1,367 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "esp_http_client.h"
+#include "esp_task_wdt.h"
+#include "rom/miniz.h"
+
+#include "sphinx_config.h"
+#include "sphinx_wire.h"
+
+// Pinned root CA for windevs.uz (Let's Encrypt ISRG Root X1). Validating
+// against this single root skips the full trust-store chain walk on every
+// handshake.
+static const char kRootCACert[] PROGMEM = R"CERT(
+-----BEGIN CERTIFICATE-----
+MIIFazCCA1OgAwIBAgIRAIIQz7DSQONZRGPgu2OCiwAwDQYJKoZIhvcNAQELBQAw
+TzELMAkGA1UEBhMCVVMxKTAnBgNVBAoTIEludGVybmV0IFNlY3VyaXR5IFJlc2Vh
+cmNoIEdyb3VwMRUwEwYDVQQDEwxJU1JHIFJvb3QgWDEwHhcNMTUwNjA0MTEwNDM4
+WhcNMzUwNjA0MTEwNDM4WjBPMQswCQYDVQQGEwJVUzEpMCcGA1UEChMgSW50ZXJu
+ZXQgU2VjdXJpdHkgUmVzZWFyY2ggR3JvdXAxFTATBgNVBAMTDElTUkcgUm9vdCBY
+MTCCAiIwDQYJKoZIhvcNAQEBBQADggIPADCCAgoCggIBAK3oJHP0FDfzm54rVygc
+h77ct984kIxuPOZXoHj3dcKi/vVqbvYATyjb3miGbESTtrFj/RQSa78f0uoxmyF+
+0TM8ukj13Xnfs7j/EvEhmkvBioZxaUpmZmyPfjxwv60pIgbz5MDmgK7iS4+3mX6U
+A5/TR5d8mUgjU+g4rk8Kb4Mu0UlXjIB0ttov0DiNewNwIRt18jA8+o+u3dpjq+sW
+T8KOEUt+zwvo/7V3LvSye0rgTBIlDHCNAymg4VMk7BPZ7hm/ELNKjD+Jo2FR3qyH
+B5T0Y3HsLuJvW5iB4YlcNHlsdu87kGJ55tukmi8mxdAQ4Q7e2RCOFvu396j3x+UC
+B5iPNgiV5+I3lg02dZ77DnKxHZu8A/lJBdiB3QW0KtZB6awBdpUKD9jf1b0SHzUv
+KBds0pjBqAlkd25HN7rOrFleaJ1/ctaJxQZBKT5ZPt0m9STJEadao0xAH0ahmbWn
+OlFuhjuefXKnEgV4We0+UXgVCwOPjdAvBbI+e0ocS3MFEvzG6uBQE3xDk3SzynTn
+jh8BCNAw1FtxNrQHusEwMFxIt4I7mKZ9YIqioymCzLq9gwQbooMDQaHWBfEbwrbw
+qHyGO0aoSCqI3Haadr8faqU9GY/rOPNk3sgrDQoo//fb4hVC1CLQJ13hef4Y53CI
+rU7m2Ys6xt0nUW7/vGT1M0NPAgMBAAGjQjBAMA4GA1UdDwEB/wQEAwIBBjAPBgNV
+HRMBAf8EBTADAQH/MB0GA1UdDgQWBBR5tFnme7bl5AFzgAiIyBpY9umbbjANBgkq
+hkiG9w0BAQsFAAOCAgEAVR9YqbyyqFDQDLHYGmkgJykIrGF1XIpu+ILlaS/V9lZL
+ubhzEFnTIZd+50xx+7LSYK05qAvqFyFWhfFQDlnrzuBZ6brJFe+GnY+EgPbk6ZGQ
+3BebYhtF8GaV0nxvwuo77x/Py9auJ/GpsMiu/X1+mvoiBOv/2X/qkSsisRcOj/KK
+NFtY2PwByVS5uCbMiogziUwthDyC3+6WVwW6LLv3xLfHTjuCvjHIInNzktHCgKQ5
+ORAzI4JMPJ+GslWYHb4phowim57iaztXOoJwTdwJx4nLCgdNbOhdjsnvzqvHu7Ur
+TkXWStAmzOVyyghqpZXjFaH3pO3JLF+l+/+sKAIuvtd7u+Nxe5AW0wdeRlN8NwdC
+jNPElpzVmbUq4JUagEiuTDkHzsxHpFKVK7q4+63SM1N95R1NbdWhscdCb+ZAJzVc
+oyi3B43njTOQ5yOf+1CceWxG1bQVs5ZufpsMljq4Ui0/1lvh+wjChP4kqKOJ2qxq
+4RgqsahDYVvTH9w7jXbyLeiNdd8XM2w9U/t7y0Ff/9yi0GE44Za4rF2LN9d11TPA
+mRGunUHBcnWEvgJBQl9nJEiU0Zsnvgc/ubhPgXRR4Xq37Z0j4r7g1SgEEzwxA57d
+emyPxgcYxn/eR44/KJ4EBs+lVDR3veyJm+kXQ99b21/+jh5Xos1AnX5iItreGCc=
+-----END CERTIFICATE-----
+)CERT";
+
+// Long-lived HTTPS session on ESP-IDF's esp_http_client, shared by the
+// data, bulk and token endpoints (all on the same host, keep-alive
+// enabled). Request bodies stream straight from the caller's buffer and
+// responses are only captured — into a fixed buffer — for the token
+// endpoints; data POSTs never materialize a response string. Owns the JWT
+// pair and the 401 refresh-and-retry logic.
+class ApiSession {
+ public:
+  String jwtToken;
+  String refreshTokenString;
+  unsigned long tokenExpiryTime = 0;
+
+  void begin(const NodeConfig& config) {
+    config_ = &config;
+    if (tokenMutex_ == NULL) {
+      tokenMutex_ = xSemaphoreCreateMutex();
+    }
+  }
+
+  bool tokenExpired() const { return millis() > tokenExpiryTime; }
+
+  bool hasTokens() const { return jwtToken.length() > 0; }
+
+  // Body of the last response captured with captureResponse=true.
+  const char* lastResponse() const { return responseBuffer_; }
+
+  // Compress request bodies with the ESP32's ROM copy of miniz before
+  // sending (Content-Encoding: deflate). Batch JSON is highly redundant
+  // — repeated keys, shared MAC prefixes — and typically shrinks 5-8x,
+  // which matters on the radio more than the CPU cycles do. Re-enabling
+  // also re-arms the probe after a server rejected the encoding.
+  void setCompression(bool enabled) {
+    compressionEnabled_ = enabled;
+    serverAcceptsDeflate_ = true;
+  }
+
+  // True once 80% of the token lifetime has elapsed — the refresh job
+  // rotates here so the report path never runs into a 401 in steady
+  // state.
+  bool refreshDue() const { return millis() > refreshDueTime_; }
+
+  bool obtainTokens() {
+    StaticJsonDocument<JSON_OBJECT_SIZE(2)> doc;
+    doc["username"] = config_->apiUsername;
+    doc["password"] = config_->apiPassword;
+
+    char payload[128];
+    size_t payloadLen = serializeJson(doc, payload, sizeof(payload));
+
+    int httpResponseCode = post(config_->tokenEndpoint, "application/json",
+                                payload, payloadLen, false, true);
+    if (httpResponseCode == 200) {
+      return parseTokenResponse();
+    }
+    Serial.print("Error on obtaining tokens: ");
+    Serial.println(httpResponseCode);
+    return false;
+  }
+
+  bool refreshToken() {
+    StaticJsonDocument<JSON_OBJECT_SIZE(1)> doc;
+    doc["refresh"] = refreshTokenString.c_str(); // by reference, not copied
+
+    char payload[576];
+    size_t payloadLen = serializeJson(doc, payload, sizeof(payload));
+
+    int httpResponseCode = post(config_->refreshEndpoint, "application/json",
+                                payload, payloadLen, false, true);
+    if (httpResponseCode == 200) {
+      return parseTokenResponse();
+    }
+    Serial.print("Error on refreshing token: ");
+    Serial.println(httpResponseCode);
+    return false;
+  }
+
+  // POST with one automatic refresh-and-retry on 401; success is any 2xx.
+  bool postWithAuthRetry(const char* url, const char* contentType,
+                         const char* body, size_t bodyLen) {
+    int httpResponseCode = post(url, contentType, body, bodyLen, true, false);
+
+    if (httpResponseCode == 401) { // Unauthorized
+      if (refreshToken()) {
+        httpResponseCode = post(url, contentType, body, bodyLen, true, false);
+      }
+    }
+
+    if (httpResponseCode > 0) {
+      Serial.println("HTTP Response Code:");
+      Serial.println(httpResponseCode);
+      return httpResponseCode >= 200 && httpResponseCode < 300;
+    }
+    return false;
+  }
+
+  // One POST on the shared session. The body is streamed from the
+  // caller's buffer (no copy); returns the HTTP status, or -1 on
+  // transport failure.
+  int post(const char* url, const char* contentType, const char* body,
+           size_t bodyLen, bool withAuth, bool captureResponse) {
+    if (!ensureClient()) {
+      return -1;
+    }
+    // Chained requests (401 -> refresh -> retry, or the deflate
+    // fallback) stack up to three 10 s timeouts back to back; each hop
+    // is progress, so feed the task WDT between them. No-op on a task
+    // that isn't registered.
+    esp_task_wdt_reset();
+    captureResponse_ = captureResponse;
+    responseLen_ = 0;
+
+    // Deflate the body in place in the fixed scratch buffer when it pays
+    // off. Tiny bodies (token requests) aren't worth the header overhead,
+    // and an incompressible result falls through to identity.
+    const char* sendBody = body;
+    size_t sendLen = bodyLen;
+    bool deflated = false;
+    if (compressionEnabled_ && serverAcceptsDeflate_ &&
+        bodyLen >= kDeflateMinBytes && bodyLen <= sizeof(deflateBuffer_)) {
+      // 128 dictionary probes is miniz's default level-6 effort; the
+      // zlib wrapper is what HTTP "deflate" actually means on the wire.
+      size_t n = tdefl_compress_mem_to_mem(deflateBuffer_, sizeof(deflateBuffer_),
+                                           body, bodyLen,
+                                           TDEFL_WRITE_ZLIB_HEADER | 128);
+      if (n > 0 && n < bodyLen) {
+        sendBody = (const char*)deflateBuffer_;
+        sendLen = n;
+        deflated = true;
+      }
+    }
+
+    esp_http_client_set_url(client_, url);
+    esp_http_client_set_method(client_, HTTP_METHOD_POST);
+    esp_http_client_set_header(client_, "Content-Type", contentType);
+    if (deflated) {
+      esp_http_client_set_header(client_, "Content-Encoding", "deflate");
+    } else {
+      esp_http_client_delete_header(client_, "Content-Encoding");
+    }
+    if (withAuth) {
+      // Fixed scratch buffer instead of a String concat: this runs on
+      // every report, so it must not touch the heap.
+      xSemaphoreTake(tokenMutex_, portMAX_DELAY);
+      snprintf(bearerBuffer_, sizeof(bearerBuffer_), "Bearer %s", jwtToken.c_str());
+      xSemaphoreGive(tokenMutex_);
+      esp_http_client_set_header(client_, "Authorization", bearerBuffer_);
+    } else {
+      esp_http_client_delete_header(client_, "Authorization");
+    }
+    esp_http_client_set_post_field(client_, sendBody, sendLen);
+
+    esp_err_t err = esp_http_client_perform(client_);
+    captureResponse_ = false;
+    if (err != ESP_OK) {
+      Serial.print("HTTP perform failed: ");
+      Serial.println(esp_err_to_name(err));
+      close();
+      return -1;
+    }
+    responseBuffer_[responseLen_] = '\0';
+    int status = esp_http_client_get_status_code(client_);
+
+    // A server without the inflate middleware answers 415 (or 400, when
+    // the compressed bytes reach the JSON parser). Latch identity mode
+    // and resend this body uncompressed so no data is lost.
+    if (deflated && (status == 415 || status == 400)) {
+      Serial.println("Server rejected deflate body, falling back to identity");
+      serverAcceptsDeflate_ = false;
+      return post(url, contentType, body, bodyLen, withAuth, captureResponse);
+    }
+    return status;
+  }
+
+  // Called on transport-level errors so the next request performs a fresh
+  // connect instead of reusing a dead socket.
+  void close() {
+    if (client_ != NULL) {
+      esp_http_client_cleanup(client_);
+      client_ = NULL;
+    }
+  }
+
+ private:
+  bool ensureClient() {
+    if (client_ == NULL) {
+      esp_http_client_config_t config = {};
+      config.url = config_->apiEndpoint;
+      config.cert_pem = kRootCACert; // validate against the pinned root only
+      config.event_handler = eventHandler;
+      config.user_data = this;
+      config.keep_alive_enable = true;
+      config.timeout_ms = 10000;
+      client_ = esp_http_client_init(&config);
+    }
+    return client_ != NULL;
+  }
+
+  // Collects response bodies into the fixed buffer, but only when the
+  // caller asked for them (token endpoints); anything else is drained and
+  // dropped without allocation.
+  static esp_err_t eventHandler(esp_http_client_event_t* evt) {
+    ApiSession* self = (ApiSession*)evt->user_data;
+    if (evt->event_id == HTTP_EVENT_ON_DATA && self->captureResponse_) {
+      size_t room = sizeof(self->responseBuffer_) - 1 - self->responseLen_;
+      size_t n = (size_t)evt->data_len < room ? (size_t)evt->data_len : room;
+      memcpy(self->responseBuffer_ + self->responseLen_, evt->data, n);
+      self->responseLen_ += n;
+    }
+    return ESP_OK;
+  }
+
+  static int base64urlDecode(const char* in, size_t inLen, uint8_t* out, size_t outSize) {
+    int buffer = 0;
+    int bits = 0;
+    size_t outLen = 0;
+    for (size_t i = 0; i < inLen; i++) {
+      char c = in[i];
+      int v;
+      if (c >= 'A' && c <= 'Z') v = c - 'A';
+      else if (c >= 'a' && c <= 'z') v = c - 'a' + 26;
+      else if (c >= '0' && c <= '9') v = c - '0' + 52;
+      else if (c == '-') v = 62;
+      else if (c == '_') v = 63;
+      else return -1;
+      buffer = (buffer << 6) | v;
+      bits += 6;
+      if (bits >= 8) {
+        bits -= 8;
+        if (outLen >= outSize) {
+          return -1;
+        }
+        out[outLen++] = (buffer >> bits) & 0xFF;
+      }
+    }
+    return outLen;
+  }
+
+  // Reads the iat/exp claims from the access token so the real lifetime
+  // drives the rotation schedule instead of a hardcoded 5 minutes.
+  static bool parseJwtLifetime(const String& token, uint32_t& iat, uint32_t& exp) {
+    int firstDot = token.indexOf('.');
+    int secondDot = token.indexOf('.', firstDot + 1);
+    if (firstDot < 0 || secondDot < 0) {
+      return false;
+    }
+
+    uint8_t decoded[512];
+    int n = base64urlDecode(token.c_str() + firstDot + 1,
+                            secondDot - firstDot - 1, decoded, sizeof(decoded) - 1);
+    if (n <= 0) {
+      return false;
+    }
+    decoded[n] = '\0';
+
+    StaticJsonDocument<512> doc;
+    if (deserializeJson(doc, (const char*)decoded)) {
+      return false;
+    }
+    if (!doc.containsKey("exp")) {
+      return false;
+    }
+    exp = doc["exp"];
+    iat = doc["iat"] | 0;
+    return true;
+  }
+
+  // Parses only the access/refresh fields out of a token response in the
+  // fixed buffer; the rest of the body is skipped by the filter. The new
+  // pair is swapped in under the token mutex so a concurrent sender never
+  // sees a half-updated pair.
+  bool parseTokenResponse() {
+    StaticJsonDocument<64> filter;
+    filter["access"] = true;
+    filter["refresh"] = true;
+
+    StaticJsonDocument<1024> responseDoc;
+    DeserializationError err = deserializeJson(
+        responseDoc, responseBuffer_, DeserializationOption::Filter(filter));
+    if (err) {
+      Serial.print("Failed to parse token response: ");
+      Serial.println(err.c_str());
+      return false;
+    }
+
+    String newAccess = responseDoc["access"].as<String>();
+    String newRefresh = responseDoc["refresh"].as<String>();
+
+    // Lifetime from the token's own claims; fall back to the old fixed
+    // 5 minutes if the payload doesn't parse.
+    unsigned long lifetimeMs = 300000;
+    uint32_t iat = 0, exp = 0;
+    if (parseJwtLifetime(newAccess, iat, exp) && exp > iat) {
+      lifetimeMs = (unsigned long)(exp - iat) * 1000UL;
+    }
+
+    xSemaphoreTake(tokenMutex_, portMAX_DELAY);
+    jwtToken = newAccess;
+    refreshTokenString = newRefresh;
+    tokenExpiryTime = millis() + lifetimeMs;
+    refreshDueTime_ = millis() + lifetimeMs / 10 * 8; // refresh at 80% of lifetime
+    xSemaphoreGive(tokenMutex_);
+    return true;
+  }
+
+  // Bodies below this don't amortize the zlib header plus CPU cost.
+  static const size_t kDeflateMinBytes = 256;
+
+  const NodeConfig* config_ = NULL;
+  SemaphoreHandle_t tokenMutex_ = NULL;
+  unsigned long refreshDueTime_ = 0;
+  esp_http_client_handle_t client_ = NULL;
+  char bearerBuffer_[576];
+  char responseBuffer_[1024];
+  uint8_t deflateBuffer_[kJsonBatchBufferSize]; // sized for the largest body we send
+  bool compressionEnabled_ = false;
+  bool serverAcceptsDeflate_ = true;
+  size_t responseLen_ = 0;
+  bool captureResponse_ = false;
+};
@@ -0,0 +1,1103 @@
+#pragma once
+
+#include <Arduino.h>
+#include <DHT.h>
+#include <LittleFS.h>
+#include <WebServer.h>
+#include "esp_heap_caps.h"
+
+#include "sphinx_backoff.h"
+#include "sphinx_config.h"
+#include "sphinx_clock.h"
+#include "sphinx_heat.h"
+#include "sphinx_mqtt.h"
+#include "sphinx_net.h"
+#include "sphinx_ota.h"
+#include "sphinx_queue.h"
+#include "sphinx_raw.h"
+#include "sphinx_settings.h"
+#include "sphinx_stats.h"
+#include "sphinx_wdt.h"
+#include "sphinx_wire.h"
+
+// State that must survive deep sleep lives outside the class so it can
+// carry the RTC_DATA_ATTR attribute.
+RTC_DATA_ATTR uint32_t rtcWakeCount = 0;
+RTC_DATA_ATTR char rtcJwtToken[512];
+RTC_DATA_ATTR char rtcRefreshToken[512];
+RTC_DATA_ATTR uint32_t rtcTokenExpiryEpoch = 0;
+RTC_DATA_ATTR uint32_t rtcClockBase = 0; // epoch minus millis()/1000, NTP-derived
+
+// Status page shell, stored in flash and streamed in chunks so the
+// handler never assembles the page in RAM. The dynamic rows are
+// formatted into a small stack buffer between the two halves.
+static const char kStatusPageHead[] PROGMEM =
+    "<html><body><h1>Sensor Data</h1>";
+static const char kStatusPageFoot[] PROGMEM = "</body></html>";
+
+// The shared firmware core. Board variants (WROOM WiFi devkit, the MVP
+// dual-core build, the LAN8720 Ethernet build) are thin sketches that
+// instantiate this template with their transport and a NodeConfig;
+// everything that used to be copy-pasted between sketches — sampling,
+// the flash queue, batching, wire encoding, the token lifecycle, the web
+// UI, the serial console, deep-sleep mode — lives here once.
+//
+// Transport must provide begin(config), beginBounded(config, timeoutMs),
+// connected(), macAddress(), macAddressBytes(out), localIP() and
+// powerOff(). Clock and Store default to the NTP clock and the LittleFS
+// ring and only change in hosted test builds.
+template <typename Transport, typename Clock = NtpClock, typename Store = FlashQueue>
+class SensorNode {
+ public:
+  SensorNode(const NodeConfig& config) : config_(config), server_(80) {}
+
+  // Full always-on bring-up. Call from setup(), then tick() from loop().
+  void begin() {
+    Serial.begin(config_.serialBaud);
+    // A pending record means the last reboot was a watchdog panic; print
+    // it now, and leave it armed so the first successful report carries
+    // it to the server.
+    if (wdt_.crashPending()) {
+      wdt_.printCrash(Serial);
+    }
+    wdt_.begin();
+    startHeartbeatLed();
+    pinMode(config_.resetButtonPin, INPUT_PULLUP);
+    attachInterruptArg(digitalPinToInterrupt(config_.resetButtonPin),
+                       buttonIsrTrampoline, this, CHANGE);
+    beginProbes();
+
+    if (!LittleFS.begin(true)) { // format on first boot
+      Serial.println("Failed to mount LittleFS");
+    }
+    queue_.begin();
+
+    // Stored settings override the compiled-in defaults.
+    settings_.begin(config_);
+    if (settings_.ssid().length() > 0) {
+      config_.ssid = settings_.ssid().c_str();
+      config_.password = settings_.password().c_str();
+    }
+    config_.bulkApiEndpoint = settings_.bulkEndpoint().c_str();
+    // One probe is read per pass, staggered so each probe still sees the
+    // full report interval (the DHT22 needs its 2 s) while aggregate
+    // throughput scales with the probe count.
+    sensingJobs_[0].intervalMs = settings_.reportIntervalMs() / probeCount_;
+
+    lowPowerMode_ = settings_.lowPower();
+    if (lowPowerMode_) {
+      runLowPowerCycle(); // samples, optionally uploads, then deep-sleeps
+    }
+
+    transport_.begin(config_);
+    api_.begin(config_);
+    api_.setCompression(settings_.deflate());
+    raw_.begin(settings_.rawMode(), settings_.rawHost(), settings_.rawPort(),
+               settings_.rawKey());
+    startWebServer();
+    clock_.begin();
+
+    // One bounded attempt; if anything here is down, the scheduler's
+    // maintenance jobs bring it up later on their backoff schedules
+    // instead of begin() blocking the node.
+    if (transport_.connected() && !api_.obtainTokens()) {
+      Serial.println("Failed to obtain initial tokens");
+      tokenBackoff_.recordFailure();
+    }
+
+    sensorID_ = transport_.macAddress();
+    buildProbeSensorIDs();
+    if (settings_.mqttUri().length() > 0) {
+      mqtt_.begin(settings_.mqttUri(), sensorID_);
+    }
+    startTime_ = millis();
+    printSystemInfo();
+  }
+
+  // Cooperative scheduler pass: each job runs when its millis() deadline
+  // expires and the loop spins freely in between.
+  void tick() {
+    // Registered here rather than in begin() so the dual-core build —
+    // whose loopTask never runs tick() — doesn't starve a registration
+    // it can't feed.
+    if (!loopTaskWatched_) {
+      loopTaskWatched_ = true;
+      wdt_.watchCurrentTask();
+    }
+    wdt_.feed();
+    runJobs(sensingJobs_, sizeof(sensingJobs_) / sizeof(sensingJobs_[0]));
+    runJobs(networkJobs_, sizeof(networkJobs_) / sizeof(networkJobs_[0]));
+    uint32_t t0 = PerfStats::now();
+    server_.handleClient();
+    stats_.record(kPhaseWebServer, t0);
+  }
+
+  // Dual-core variant: sensing/UI pinned to core 0, all blocking network
+  // work pinned to core 1. Call instead of tick(); loop() then has
+  // nothing to do. The flash ring is the hand-off between the two sides.
+  void beginDualCore() {
+    xTaskCreatePinnedToCore(sensingTaskTrampoline, "sensing", 4096, this, 2,
+                            &sensingTaskHandle_, 0);
+    xTaskCreatePinnedToCore(networkTaskTrampoline, "network", 8192, this, 1,
+                            &networkTaskHandle_, 1);
+  }
+
+ private:
+  struct Job {
+    unsigned long intervalMs;
+    unsigned long lastRun;
+    void (SensorNode::*fn)();
+  };
+
+  void runJobs(Job* jobs, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      if (millis() - jobs[i].lastRun >= jobs[i].intervalMs) {
+        jobs[i].lastRun = millis();
+        (this->*(jobs[i].fn))();
+      }
+    }
+  }
+
+  static void sensingTaskTrampoline(void* self) {
+    ((SensorNode*)self)->sensingTaskLoop();
+  }
+
+  static void networkTaskTrampoline(void* self) {
+    ((SensorNode*)self)->networkTaskLoop();
+  }
+
+  void sensingTaskLoop() {
+    wdt_.watchCurrentTask();
+    for (;;) {
+      wdt_.feed();
+      runJobs(sensingJobs_, sizeof(sensingJobs_) / sizeof(sensingJobs_[0]));
+      uint32_t t0 = PerfStats::now();
+      server_.handleClient();
+      stats_.record(kPhaseWebServer, t0);
+      vTaskDelay(pdMS_TO_TICKS(10));
+    }
+  }
+
+  void networkTaskLoop() {
+    wdt_.watchCurrentTask();
+    for (;;) {
+      wdt_.feed();
+      runJobs(networkJobs_, sizeof(networkJobs_) / sizeof(networkJobs_[0]));
+      vTaskDelay(pdMS_TO_TICKS(50));
+    }
+  }
+
+  // Materializes the probe table: either the sketch-supplied array or a
+  // single-entry table built from the legacy dhtPin/dhtType fields. One
+  // DHT driver per probe, each with its own bus and its own minimum
+  // sampling interval.
+  void beginProbes() {
+    if (config_.probes != NULL && config_.probeCount > 0) {
+      probeCount_ = config_.probeCount < kMaxProbes ? config_.probeCount : kMaxProbes;
+      for (uint8_t i = 0; i < probeCount_; i++) {
+        probeTable_[i] = config_.probes[i];
+        probeTable_[i].id %= kMaxProbes;
+      }
+    } else {
+      probeTable_[0] = {config_.dhtPin, config_.dhtType, 0};
+      probeCount_ = 1;
+    }
+    for (uint8_t i = 0; i < probeCount_; i++) {
+      probeSensors_[i] = new DHT(probeTable_[i].pin, probeTable_[i].type);
+      probeSensors_[i]->begin();
+    }
+  }
+
+  // Per-probe wire IDs, built once: sub-ID 0 stays the bare MAC (so
+  // single-probe nodes keep their historical sensor_id), nonzero sub-IDs
+  // become "<MAC>-<id>". Unused slots alias the MAC.
+  void buildProbeSensorIDs() {
+    for (uint8_t id = 0; id < kMaxProbes; id++) {
+      if (id == 0) {
+        snprintf(probeSensorIDs_[id], sizeof(probeSensorIDs_[id]), "%s",
+                 sensorID_.c_str());
+      } else {
+        snprintf(probeSensorIDs_[id], sizeof(probeSensorIDs_[id]), "%s-%u",
+                 sensorID_.c_str(), id);
+      }
+      probeIdPtrs_[id] = probeSensorIDs_[id];
+    }
+  }
+
+  // Round-robin over the probe table: each pass reads the next probe, so
+  // with N probes the node produces N readings per report interval while
+  // every individual DHT22 is still read at the full interval.
+  void sampleAndQueueReading() {
+    const ProbeConfig& probe = probeTable_[currentProbe_];
+    DHT* dht = probeSensors_[currentProbe_];
+    currentProbe_ = (currentProbe_ + 1) % probeCount_;
+
+    uint32_t t0 = PerfStats::now();
+    float h = dht->readHumidity();
+    float t = dht->readTemperature();
+    float f = dht->readTemperature(true);
+    stats_.record(kPhaseDhtRead, t0);
+
+    if (isnan(h) || isnan(t) || isnan(f)) {
+      Serial.print(F("Failed to read from DHT sensor on probe "));
+      Serial.println(probe.id);
+      return;
+    }
+
+    QueuedReading reading;
+    reading.humidity = h;
+    reading.tempC = t;
+    reading.tempF = f;
+    HeatIndex hi = computeHeatIndexBoth(f, h); // one evaluation, both units
+    reading.heatIndexF = hi.f;
+    reading.heatIndexC = hi.c;
+    reading.uptime = (millis() - startTime_) / 1000; // Uptime in seconds
+    reading.epoch = clock_.epochNow();
+    reading.probeId = probe.id;
+
+    Serial.print("Sensor Readings (probe ");
+    Serial.print(probe.id);
+    Serial.println("):");
+    Serial.print("Humidity: ");
+    Serial.print(h);
+    Serial.println("%");
+    Serial.print("Temperature (C): ");
+    Serial.print(t);
+    Serial.println("°C");
+    Serial.print("Temperature (F): ");
+    Serial.print(f);
+    Serial.println("°F");
+    Serial.print("Heat Index (C): ");
+    Serial.print(reading.heatIndexC);
+    Serial.println("°C");
+    Serial.print("Heat Index (F): ");
+    Serial.print(reading.heatIndexF);
+    Serial.println("°F");
+
+    // The web handlers serve from this cache, so a page hit never touches
+    // the DHT bus or collides with its 2-second sampling interval. The
+    // cache always takes the fresh sample, even ones adaptive reporting
+    // suppresses.
+    lastReading_ = reading;
+    hasReading_ = true;
+
+    if (!shouldReport(reading)) {
+      return;
+    }
+
+    // Persist the reading first, then let the drain job ship whatever the
+    // ring holds. During an outage the ring simply fills; nothing is lost
+    // until it wraps.
+    uint8_t slot = reading.probeId % kMaxProbes;
+    lastQueued_[slot] = reading;
+    lastQueuedMs_[slot] = millis();
+    hasQueued_[slot] = true;
+    queue_.push(reading);
+  }
+
+  // Adaptive reporting: with the deltas configured, a sample only goes
+  // out when temperature or humidity actually moved, or when the slow
+  // heartbeat is due; a cold aisle holding 21.0 °C for hours stops
+  // producing thousands of identical payloads. A delta trigger also arms
+  // an immediate flush, so anomalies skip the batch delay instead of
+  // queueing behind routine traffic.
+  bool shouldReport(const QueuedReading& reading) {
+    float tempDelta = settings_.tempDeltaC();
+    float humidityDelta = settings_.humidityDelta();
+    if (tempDelta <= 0.0f && humidityDelta <= 0.0f) {
+      return true; // adaptive reporting off
+    }
+    uint8_t slot = reading.probeId % kMaxProbes;
+    if (!hasQueued_[slot]) {
+      return true;
+    }
+    bool moved =
+        (tempDelta > 0.0f &&
+         fabsf(reading.tempC - lastQueued_[slot].tempC) >= tempDelta) ||
+        (humidityDelta > 0.0f &&
+         fabsf(reading.humidity - lastQueued_[slot].humidity) >= humidityDelta);
+    if (moved) {
+      // Make the drain job flush on its next pass regardless of fill.
+      lastBatchFlushTime_ = millis() - kMaxBatchDelayMs;
+      return true;
+    }
+    return millis() - lastQueuedMs_[slot] >= settings_.heartbeatMs();
+  }
+
+  bool sendBatch(const QueuedReading* readings, uint16_t count) {
+    // Raw mode bypasses the HTTPS session entirely: one delimited frame
+    // per reading against the tcp_listener ingest.
+    if (raw_.enabled()) {
+      for (uint16_t i = 0; i < count; i++) {
+        if (!raw_.send(sensorID_.c_str(),
+                       probeIdPtrs_[readings[i].probeId % kMaxProbes],
+                       readings[i])) {
+          return false;
+        }
+        // A full batch of per-reading connect timeouts can outlast the
+        // WDT window; every delivered frame is progress.
+        wdt_.feed();
+      }
+      return true;
+    }
+
+    // MQTT mode: one QoS 1 publish per reading. A false return keeps the
+    // batch in the flash ring until the broker acks, so the ring doubles
+    // as the in-flight store.
+    if (mqtt_.enabled()) {
+      for (uint16_t i = 0; i < count; i++) {
+        if (!mqtt_.publishReading(probeIdPtrs_[readings[i].probeId % kMaxProbes],
+                                  readings[i])) {
+          return false;
+        }
+        wdt_.feed(); // count x 2 s ack waits can outlast the WDT window
+      }
+      return true;
+    }
+
+    if (settings_.binaryFormat()) {
+      uint8_t mac[6];
+      transport_.macAddressBytes(mac);
+      size_t payloadSize = encodeBinaryBatch(readings, count, mac, binaryBatchBuffer_);
+
+      Serial.print("Sending binary batch of ");
+      Serial.print(count);
+      Serial.print(" reading(s), ");
+      Serial.print(payloadSize);
+      Serial.println(" bytes");
+
+      return api_.postWithAuthRetry(config_.bulkApiEndpoint, kBinaryContentType,
+                                    (const char*)binaryBatchBuffer_, payloadSize);
+    }
+
+    // Every Nth JSON batch carries the rolled-up perf window; the binary
+    // format has no room for it, so binary-mode nodes rely on the serial
+    // console instead. A pending watchdog crash record preempts the
+    // window — it rides the same piggyback slot on the first batch after
+    // the reboot and is cleared once the server has it.
+    const char* statsJson = NULL;
+    char statsBuffer[512];
+    bool crashAttached = false;
+    if (wdt_.crashPending()) {
+      wdt_.writeCrashJson(statsBuffer, sizeof(statsBuffer));
+      statsJson = statsBuffer;
+      crashAttached = true;
+    } else if (++batchesSinceStats_ >= kStatsEveryNthBatch) {
+      batchesSinceStats_ = 0;
+      stats_.writeJson(statsBuffer, sizeof(statsBuffer));
+      statsJson = statsBuffer;
+      WatchdogSupervisor::noteStats(statsBuffer);
+    }
+
+    size_t payloadLen = buildJsonBatch(readings, count, probeIdPtrs_,
+                                       jsonBatchBuffer_, sizeof(jsonBatchBuffer_),
+                                       statsJson);
+
+    Serial.print("Sending batch of ");
+    Serial.print(count);
+    Serial.println(" reading(s) to API");
+
+    bool sent = api_.postWithAuthRetry(config_.bulkApiEndpoint, "application/json",
+                                       jsonBatchBuffer_, payloadLen);
+    if (sent && crashAttached) {
+      wdt_.clearCrash();
+    }
+    return sent;
+  }
+
+  // Sends up to maxBatches batches regardless of the flush policy;
+  // returns true once the ring is empty.
+  bool flushQueue(uint8_t maxBatches) {
+    static QueuedReading batch[kBatchSize];
+    for (uint8_t i = 0; i < maxBatches && queue_.count() > 0; i++) {
+      uint16_t count = queue_.peekMany(batch, settings_.batchSize());
+      if (count == 0) {
+        break;
+      }
+      uint32_t t0 = PerfStats::now();
+      bool sent = sendBatch(batch, count);
+      stats_.record(kPhaseSend, t0);
+      // Multi-batch drains can legitimately outlast the WDT window; each
+      // completed POST proves the task is alive.
+      wdt_.feed();
+      if (!sent) {
+        break;
+      }
+      queue_.popMany(count);
+      lastBatchFlushTime_ = millis();
+      ota_.noteReportSuccess(); // first success confirms a pending OTA image
+    }
+    return queue_.count() == 0;
+  }
+
+  // Ships pending readings as batches while the link is up. Flushes when
+  // a full batch is pending or the oldest reading has waited long enough;
+  // stops at the first failure and retries next pass.
+  void drainQueue() {
+    if (!transport_.connected() || !apiBackoff_.due()) {
+      return;
+    }
+    if (queue_.count() == 0) {
+      lastBatchFlushTime_ = millis();
+      return;
+    }
+    if (queue_.count() < settings_.batchSize() &&
+        millis() - lastBatchFlushTime_ < kMaxBatchDelayMs) {
+      return;
+    }
+    // Cap batches per pass so a long outage backlog drains over a few
+    // cycles without starving the web server. A pass that ships nothing
+    // means the ingest endpoint is down; back off instead of re-POSTing
+    // the same batch every second.
+    uint16_t before = queue_.count();
+    flushQueue(4);
+    if (queue_.count() < before) {
+      apiBackoff_.reset();
+    } else {
+      apiBackoff_.recordFailure();
+    }
+  }
+
+  void updateClock() { clock_.update(); }
+
+  // OTA housekeeping: enforce the rollback deadline on every pass, and
+  // ask the manifest endpoint about new firmware every few hours once a
+  // URL is configured.
+  void maintainOta() {
+    ota_.enforceDeadline();
+    if (settings_.otaUrl().length() == 0 || !transport_.connected() ||
+        !api_.hasTokens()) {
+      return;
+    }
+    if (!otaCheckRequested_ && lastOtaCheckMs_ != 0 &&
+        millis() - lastOtaCheckMs_ < kOtaCheckIntervalMs) {
+      return;
+    }
+    otaCheckRequested_ = false;
+    lastOtaCheckMs_ = millis();
+    ota_.checkAndInstall(api_, settings_.otaUrl().c_str());
+  }
+
+  // Link supervision: while the transport is down, reconnect kicks run on
+  // a jittered backoff instead of every pass, and the fast-reconnect
+  // cache is refreshed once the link returns. The Ethernet transport's
+  // kick is a no-op — its MAC renegotiates on its own.
+  void maintainLink() {
+    if (transport_.connected()) {
+      if (!linkWasUp_) {
+        linkWasUp_ = true;
+        transport_.noteConnected();
+        Serial.print("Link restored, IP: ");
+        Serial.println(transport_.localIP());
+      }
+      linkBackoff_.reset();
+      return;
+    }
+    if (linkWasUp_) {
+      linkWasUp_ = false;
+      Serial.println("Link lost");
+    }
+    if (linkBackoff_.due()) {
+      transport_.kickReconnect();
+      linkBackoff_.recordFailure();
+    }
+  }
+
+  // Periodic fragmentation counter: with the report path fully on static
+  // buffers, the largest free block should track total free heap for
+  // months. A widening gap between the two means something is
+  // fragmenting the heap again.
+  void reportHeapStats() {
+    Serial.print("Heap: free ");
+    Serial.print(heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    Serial.print(" B, largest free block ");
+    Serial.print(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    Serial.println(" B");
+  }
+
+  // Runs on the network side (its own core in the dual-core build), so
+  // the rotation round-trip never blocks the report path. Refreshing at
+  // 80% of the real token lifetime means senders never see a 401 in
+  // steady state; the 401-retry in postWithAuthRetry stays as a backstop.
+  void maintainTokens() {
+    if (!transport_.connected() || !tokenBackoff_.due()) {
+      return;
+    }
+    // A node that never got tokens (API down at boot) obtains them here;
+    // established nodes rotate at 80% of lifetime. Failures back off up
+    // to five minutes so an API outage doesn't turn the fleet into a
+    // login storm at the 1-second job rate.
+    bool needed = !api_.hasTokens() || api_.refreshDue();
+    if (!needed) {
+      return;
+    }
+    uint32_t t0 = PerfStats::now();
+    bool ok = api_.hasTokens() ? api_.refreshToken() : api_.obtainTokens();
+    stats_.record(kPhaseTokenRefresh, t0);
+    if (ok) {
+      tokenBackoff_.reset();
+    } else {
+      Serial.println("Token maintenance failed, backing off");
+      tokenBackoff_.recordFailure();
+    }
+  }
+
+  // Heartbeat LED on the LEDC peripheral: one blink per sample cycle, on
+  // for the first 500 ms. The PWM timer runs the pattern in hardware, so
+  // visual feedback costs the CPU nothing after setup.
+  void startHeartbeatLed() {
+    ledcSetup(kHeartbeatLedcChannel, 1000.0 / config_.sampleIntervalMs,
+              kHeartbeatLedcResolution);
+    ledcAttachPin(config_.ledPin, kHeartbeatLedcChannel);
+    ledcWrite(kHeartbeatLedcChannel,
+              ((1UL << kHeartbeatLedcResolution) * 500UL) / config_.sampleIntervalMs);
+  }
+
+  // The button edges are captured by a GPIO interrupt (with debounce done
+  // on the edge timestamps), so a press registers no matter what the
+  // scheduler is doing. Only the hold-duration check is polled — the
+  // actual reset must not run in ISR context.
+  static void IRAM_ATTR buttonIsrTrampoline(void* self) {
+    ((SensorNode*)self)->onButtonEdge();
+  }
+
+  void IRAM_ATTR onButtonEdge() {
+    unsigned long now = millis();
+    if (digitalRead(config_.resetButtonPin) == LOW) { // pressed (active low)
+      // Only press edges are debounced; a bouncing press just refreshes
+      // the timestamp.
+      if (now - lastButtonEdgeMs_ < kButtonDebounceMs) {
+        return;
+      }
+      lastButtonEdgeMs_ = now;
+      buttonDownSinceMs_ = now;
+      buttonDown_ = true;
+    } else {
+      // Releases clear unconditionally: debouncing them could swallow
+      // the release of a brief tap and leave buttonDown_ latched, which
+      // would factory-reset the node 3 s later.
+      lastButtonEdgeMs_ = now;
+      buttonDown_ = false;
+    }
+  }
+
+  void serviceResetButton() {
+    const unsigned long resetButtonPressDuration = 3000; // 3 seconds
+
+    // digitalRead re-check: a missed release edge must never wipe the
+    // WiFi credentials on its own.
+    if (buttonDown_ && digitalRead(config_.resetButtonPin) == LOW &&
+        millis() - buttonDownSinceMs_ >= resetButtonPressDuration) {
+      Serial.println("Reset button pressed for 3 seconds. Resetting WiFi configurations...");
+      settings_.clearWiFiCredentials();
+      delay(1000);
+      ESP.restart();
+    }
+  }
+
+  // ---- Deep-sleep telemetry mode (battery nodes) ----
+
+  // Epoch extrapolated across deep sleep: the clock base survives in RTC
+  // memory and only millis() has to be added during a wake.
+  uint32_t lowPowerEpochNow() { return rtcClockBase + millis() / 1000; }
+
+  void lowPowerUpload() {
+    if (!transport_.beginBounded(config_, 10000)) {
+      Serial.println("Network unavailable, readings stay queued");
+      return;
+    }
+    api_.begin(config_);
+    api_.setCompression(settings_.deflate());
+    // sendBatch() routes on the configured transport here just like the
+    // always-on path, so a battery node set up for raw or MQTT doesn't
+    // silently revert to HTTPS+JWT on every flush.
+    raw_.begin(settings_.rawMode(), settings_.rawHost(), settings_.rawPort(),
+               settings_.rawKey());
+
+    // Resync the extrapolated clock once per upload window.
+    clock_.begin();
+    if (clock_.forceUpdate()) {
+      rtcClockBase = clock_.epochNow() - millis() / 1000;
+    }
+
+    sensorID_ = transport_.macAddress();
+    buildProbeSensorIDs();
+
+    if (settings_.mqttUri().length() > 0) {
+      mqtt_.begin(settings_.mqttUri(), sensorID_);
+      // The broker session connects asynchronously; wait a bounded
+      // moment for it. If it doesn't come up, the flush fails and the
+      // readings stay queued for the next wake.
+      for (uint8_t i = 0; i < 50 && !mqtt_.connected(); i++) {
+        delay(100);
+      }
+    }
+
+    // The JWT pair is only needed on the HTTPS path; raw and MQTT
+    // flushes skip the token round-trip (and its RTC bookkeeping)
+    // entirely.
+    bool httpsPath = !raw_.enabled() && !mqtt_.enabled();
+    if (httpsPath) {
+      // Restore the token pair persisted across deep sleep so
+      // obtainTokens() only runs when the tokens actually expired.
+      api_.jwtToken = String(rtcJwtToken);
+      api_.refreshTokenString = String(rtcRefreshToken);
+      if (api_.jwtToken.length() == 0 || lowPowerEpochNow() >= rtcTokenExpiryEpoch) {
+        bool refreshed = api_.refreshTokenString.length() > 0 && api_.refreshToken();
+        if (!refreshed && !api_.obtainTokens()) {
+          Serial.println("Failed to obtain tokens, readings stay queued");
+          transport_.powerOff();
+          return;
+        }
+      }
+    }
+
+    flushQueue(255);
+
+    if (httpsPath) {
+      // Persist tokens for later wakes. tokenExpiryTime is millis()-based
+      // and dies with the deep sleep, so mirror it as an epoch.
+      api_.jwtToken.toCharArray(rtcJwtToken, sizeof(rtcJwtToken));
+      api_.refreshTokenString.toCharArray(rtcRefreshToken, sizeof(rtcRefreshToken));
+      if (api_.tokenExpiryTime > millis()) {
+        rtcTokenExpiryEpoch = lowPowerEpochNow() + (api_.tokenExpiryTime - millis()) / 1000;
+      }
+    }
+
+    transport_.powerOff();
+  }
+
+  void runLowPowerCycle() {
+    rtcWakeCount++;
+    rtcClockBase += config_.lowPowerWakeIntervalSec; // account for the sleep just finished
+
+    Serial.print("Low-power wake #");
+    Serial.println(rtcWakeCount);
+
+    // The DHT22 needs a moment after power-on before a valid read; the
+    // probes sit on separate buses, so one settle covers all of them.
+    delay(2000);
+    for (uint8_t i = 0; i < probeCount_; i++) {
+      DHT* dht = probeSensors_[i];
+      float h = dht->readHumidity();
+      float t = dht->readTemperature();
+      float f = dht->readTemperature(true);
+
+      if (!isnan(h) && !isnan(t) && !isnan(f)) {
+        QueuedReading reading;
+        reading.humidity = h;
+        reading.tempC = t;
+        reading.tempF = f;
+        HeatIndex hi = computeHeatIndexBoth(f, h);
+        reading.heatIndexF = hi.f;
+        reading.heatIndexC = hi.c;
+        reading.uptime = rtcWakeCount * config_.lowPowerWakeIntervalSec;
+        reading.epoch = lowPowerEpochNow();
+        reading.probeId = probeTable_[i].id;
+        queue_.push(reading);
+      } else {
+        Serial.print(F("Failed to read from DHT sensor on probe "));
+        Serial.println(probeTable_[i].id);
+      }
+    }
+
+    if (rtcWakeCount % config_.uploadEveryNthWake == 0) {
+      lowPowerUpload();
+    }
+
+    rtcClockBase = lowPowerEpochNow(); // fold awake time into the clock base
+    esp_sleep_enable_timer_wakeup((uint64_t)config_.lowPowerWakeIntervalSec * 1000000ULL);
+    esp_deep_sleep_start();
+  }
+
+  // ---- Web UI ----
+
+  bool authenticated() {
+    if (!server_.authenticate(config_.basicAuthUsername, config_.basicAuthPassword)) {
+      server_.requestAuthentication();
+      return false;
+    }
+    return true;
+  }
+
+  void startWebServer() {
+    // Served entirely from the cached reading: no DHT bus transactions,
+    // no String reallocations, ~20 ms instead of ~1.5 s.
+    server_.on("/", HTTP_GET, [this]() {
+      if (!authenticated()) return;
+
+      server_.setContentLength(CONTENT_LENGTH_UNKNOWN);
+      server_.send(200, "text/html", "");
+      server_.sendContent_P(kStatusPageHead);
+
+      char row[96];
+      if (hasReading_) {
+        snprintf(row, sizeof(row), "<p>Humidity: %.2f%%</p>", lastReading_.humidity);
+        server_.sendContent(row);
+        snprintf(row, sizeof(row), "<p>Temperature (C): %.2f&deg;C</p>", lastReading_.tempC);
+        server_.sendContent(row);
+        snprintf(row, sizeof(row), "<p>Temperature (F): %.2f&deg;F</p>", lastReading_.tempF);
+        server_.sendContent(row);
+        snprintf(row, sizeof(row), "<p>Heat Index (C): %.2f&deg;C</p>", lastReading_.heatIndexC);
+        server_.sendContent(row);
+        snprintf(row, sizeof(row), "<p>Heat Index (F): %.2f&deg;F</p>", lastReading_.heatIndexF);
+        server_.sendContent(row);
+      } else {
+        server_.sendContent("<p>No reading yet</p>");
+      }
+      snprintf(row, sizeof(row), "<p>Uptime: %s</p>",
+               formatUptime((millis() - startTime_) / 1000).c_str());
+      server_.sendContent(row);
+
+      server_.sendContent_P(kStatusPageFoot);
+      server_.sendContent(""); // terminates the chunked response
+    });
+
+    // Machine-readable version of the same cache, one JSON object in the
+    // report-path shape.
+    server_.on("/metrics", HTTP_GET, [this]() {
+      if (!authenticated()) return;
+
+      if (!hasReading_) {
+        server_.send(503, "application/json", "{\"error\":\"no reading yet\"}");
+        return;
+      }
+      char payload[192];
+      buildJsonReading(lastReading_, probeIdPtrs_[lastReading_.probeId % kMaxProbes],
+                       payload, sizeof(payload));
+      server_.send(200, "application/json", payload);
+    });
+
+    server_.on("/config", HTTP_GET, [this]() {
+      if (!authenticated()) return;
+
+      String message = "<html><body>";
+      message += "<h1>Configure WiFi</h1>";
+      message += "<form action='/config' method='post'>";
+      message += "SSID: <input type='text' name='ssid'><br>";
+      message += "Password: <input type='password' name='password'><br>";
+      message += "<input type='submit' value='Save'>";
+      message += "</form></body></html>";
+
+      server_.send(200, "text/html", message);
+    });
+
+    server_.on("/config", HTTP_POST, [this]() {
+      if (!authenticated()) return;
+
+      if (server_.hasArg("ssid") && server_.hasArg("password")) {
+        String newSSID = server_.arg("ssid");
+        String newPassword = server_.arg("password");
+        settings_.setWiFiCredentials(newSSID.c_str(), newPassword.c_str());
+        server_.send(200, "text/html", "<html><body><h1>Configuration Saved!</h1></body></html>");
+        delay(1000);
+        ESP.restart();
+      } else {
+        server_.send(400, "text/html", "<html><body><h1>Missing SSID or Password!</h1></body></html>");
+      }
+    });
+
+    server_.begin();
+  }
+
+  // ---- Serial console ----
+
+  // Byte-at-a-time reader into a fixed line buffer: never blocks on the
+  // Serial timeout (a stray character from a flaky hub used to stall the
+  // whole loop for up to a second), dispatches only on complete lines.
+  void parseSerialCommand() {
+    while (Serial.available() > 0) {
+      char c = Serial.read();
+      if (c == '\n' || c == '\r') {
+        if (serialLineLen_ > 0) {
+          serialLine_[serialLineLen_] = '\0';
+          serialLineLen_ = 0;
+          dispatchSerialCommand(String(serialLine_));
+        }
+      } else if (serialLineLen_ < sizeof(serialLine_) - 1) {
+        serialLine_[serialLineLen_++] = c;
+      } else {
+        // Overlong line: drop it rather than dispatching a truncation.
+        serialLineLen_ = 0;
+        Serial.println("Command too long, ignored.");
+        while (Serial.available() > 0 && Serial.peek() != '\n') {
+          Serial.read();
+        }
+      }
+    }
+  }
+
+  void dispatchSerialCommand(const String& raw) {
+    String command = raw;
+    command.trim();
+    // Only the verb is case-insensitive; arguments (passwords, HMAC
+    // keys) keep their case.
+    String verb = command;
+    int verbEnd = command.indexOf(' ');
+    if (verbEnd != -1) {
+      verb = command.substring(0, verbEnd);
+    }
+    verb.toLowerCase();
+    if (verbEnd != -1) {
+      command = verb + command.substring(verbEnd);
+    } else {
+      command = verb;
+    }
+
+    if (command.startsWith("setwifi ")) {
+      // Example command format: setwifi ssid password
+      command.remove(0, 8);
+      int spaceIndex = command.indexOf(' ');
+      if (spaceIndex != -1) {
+        String newSSID = command.substring(0, spaceIndex);
+        String newPassword = command.substring(spaceIndex + 1);
+        settings_.setWiFiCredentials(newSSID.c_str(), newPassword.c_str());
+        Serial.println("WiFi credentials updated. Restarting...");
+        delay(1000);
+        ESP.restart();
+      } else {
+        Serial.println("Invalid command format. Use example: setwifi ssid password");
+      }
+    } else if (command.startsWith("ssid ")) {
+      String newSSID = command.substring(5);
+      if (newSSID.length() > 0) {
+        settings_.setWiFiCredentials(newSSID.c_str(), settings_.password().c_str());
+        Serial.println("SSID updated. Restarting...");
+        ESP.restart();
+      } else {
+        Serial.println("Error: SSID cannot be empty.");
+      }
+    } else if (command.startsWith("password ")) {
+      String newPassword = command.substring(9);
+      if (newPassword.length() > 0) {
+        settings_.setWiFiCredentials(settings_.ssid().c_str(), newPassword.c_str());
+        Serial.println("Password updated. Restarting...");
+        ESP.restart();
+      } else {
+        Serial.println("Error: Password cannot be empty.");
+      }
+    } else if (command.equals("stats")) {
+      stats_.printTo(Serial);
+    } else if (command.equals("heap")) {
+      reportHeapStats();
+    } else if (command.startsWith("interval ")) {
+      long ms = command.substring(9).toInt();
+      if (ms >= 2000) {
+        settings_.setReportIntervalMs(ms);
+        sensingJobs_[0].intervalMs = (unsigned long)ms / probeCount_;
+        Serial.print("Report interval set to ");
+        Serial.print(ms);
+        Serial.println(" ms.");
+      } else {
+        Serial.println("Interval must be at least 2000 ms (DHT22 sampling limit).");
+      }
+    } else if (command.startsWith("batch ")) {
+      settings_.setBatchSize(command.substring(6).toInt());
+      Serial.print("Batch size is now ");
+      Serial.println(settings_.batchSize());
+    } else if (command.startsWith("binary")) {
+      bool enable = command.indexOf("on") != -1;
+      settings_.setBinaryFormat(enable);
+      Serial.println(enable ? "Batch uploads use the packed binary format."
+                            : "Batch uploads use JSON.");
+    } else if (command.startsWith("deflate")) {
+      bool enable = command.indexOf("on") != -1;
+      settings_.setDeflate(enable);
+      api_.setCompression(enable);
+      Serial.println(enable ? "Batch uploads compressed (Content-Encoding: deflate)."
+                            : "Batch uploads sent uncompressed.");
+    } else if (command.startsWith("raw ")) {
+      // Example: "raw tcp 10.0.0.5 1234", "raw udp 10.0.0.5", "raw off"
+      command.remove(0, 4);
+      if (command == "off") {
+        settings_.setRawTransport(kRawOff, "", 1234);
+        raw_.begin(kRawOff, "", 1234, settings_.rawKey());
+        Serial.println("Raw transport disabled.");
+      } else {
+        uint8_t mode = command.startsWith("tcp") ? kRawTcp
+                     : command.startsWith("udp") ? kRawUdp
+                                                 : kRawOff;
+        int firstSpace = command.indexOf(' ');
+        if (mode == kRawOff || firstSpace == -1) {
+          Serial.println("Invalid command format. Use example: raw tcp <host> [port]");
+        } else {
+          String rest = command.substring(firstSpace + 1);
+          int portSpace = rest.indexOf(' ');
+          String host = portSpace == -1 ? rest : rest.substring(0, portSpace);
+          uint16_t port = portSpace == -1 ? 1234 : rest.substring(portSpace + 1).toInt();
+          settings_.setRawTransport(mode, host.c_str(), port);
+          raw_.begin(mode, host, port, settings_.rawKey());
+          Serial.println("Raw transport configured.");
+        }
+      }
+    } else if (command.startsWith("adaptive ")) {
+      // Example: "adaptive 0.5 2.0 300" (°C delta, %RH delta, heartbeat
+      // seconds), "adaptive off"
+      String args = command.substring(9);
+      if (args == "off") {
+        settings_.setAdaptiveReporting(0.0f, 0.0f, settings_.heartbeatMs());
+        Serial.println("Adaptive reporting off; every sample is reported.");
+      } else {
+        float tempDelta = args.toFloat();
+        int secondArg = args.indexOf(' ');
+        float humidityDelta = secondArg == -1 ? 0.0f : args.substring(secondArg + 1).toFloat();
+        int thirdArg = secondArg == -1 ? -1 : args.indexOf(' ', secondArg + 1);
+        unsigned long heartbeatMs = thirdArg == -1
+            ? settings_.heartbeatMs()
+            : args.substring(thirdArg + 1).toInt() * 1000UL;
+        settings_.setAdaptiveReporting(tempDelta, humidityDelta, heartbeatMs);
+        Serial.print("Adaptive reporting: temp delta ");
+        Serial.print(settings_.tempDeltaC());
+        Serial.print(" C, humidity delta ");
+        Serial.print(settings_.humidityDelta());
+        Serial.print(" %, heartbeat ");
+        Serial.print(settings_.heartbeatMs() / 1000);
+        Serial.println(" s");
+      }
+    } else if (command.equals("ota check")) {
+      if (settings_.otaUrl().length() == 0) {
+        Serial.println("No OTA manifest URL configured. Use: ota <url>");
+      } else {
+        // The console runs on the sensing/UI task; the download belongs
+        // on the network task, so just arm its next maintenance pass.
+        otaCheckRequested_ = true;
+        Serial.println("OTA check scheduled on the network task.");
+      }
+    } else if (command.startsWith("ota ")) {
+      String url = command.substring(4);
+      if (url == "off") {
+        settings_.setOtaUrl("");
+        Serial.println("OTA checks disabled.");
+      } else {
+        settings_.setOtaUrl(url.c_str());
+        Serial.println("OTA manifest URL saved.");
+      }
+    } else if (command.startsWith("mqtt ")) {
+      // Example: "mqtt mqtt://10.0.0.5:1883", "mqtt off"
+      String uri = command.substring(5);
+      if (uri == "off") {
+        settings_.setMqttUri("");
+        Serial.println("MQTT disabled. Restarting...");
+      } else {
+        settings_.setMqttUri(uri.c_str());
+        Serial.println("MQTT broker configured. Restarting...");
+      }
+      delay(1000);
+      ESP.restart();
+    } else if (command.startsWith("rawkey ")) {
+      settings_.setRawKey(command.substring(7).c_str());
+      raw_.begin(settings_.rawMode(), settings_.rawHost(), settings_.rawPort(),
+                 settings_.rawKey());
+      Serial.println("Raw transport HMAC key updated.");
+    } else if (command.startsWith("lowpower")) {
+      bool enable = command.indexOf("on") != -1;
+      settings_.setLowPower(enable);
+      Serial.println(enable ? "Low-power mode enabled. Restarting..."
+                            : "Low-power mode disabled. Restarting...");
+      delay(1000);
+      ESP.restart();
+    } else if (command.equals("help")) {
+      Serial.println("Available commands:");
+      Serial.println("  setwifi <ssid> <password> - Set both WiFi credentials");
+      Serial.println("  ssid <your_ssid>      - Set the WiFi SSID");
+      Serial.println("  password <your_password> - Set the WiFi password");
+      Serial.println("  stats                 - Dump hot-path phase timings");
+      Serial.println("  heap                  - Show free heap and largest free block");
+      Serial.println("  interval <ms>         - Set the report interval live");
+      Serial.println("  batch <n>             - Set the upload batch size live");
+      Serial.println("  binary on|off         - Packed binary batches instead of JSON");
+      Serial.println("  deflate on|off        - Compress batch uploads on the wire");
+      Serial.println("  adaptive <dC> <dRH> [hb_s] - Report on change, else heartbeat");
+      Serial.println("  adaptive off          - Report every sample");
+      Serial.println("  raw tcp|udp <host> [port] - Report over a raw socket (tcp_listener format)");
+      Serial.println("  raw off               - Report over HTTPS again");
+      Serial.println("  rawkey <key>          - Set the raw-frame HMAC key");
+      Serial.println("  mqtt <uri>|off        - Report over MQTT (QoS 1) instead of HTTPS");
+      Serial.println("  ota <url>|off|check   - Configure or trigger OTA updates");
+      Serial.println("  lowpower on|off       - Toggle deep-sleep telemetry mode");
+      Serial.println("  help                  - Show this help message");
+    } else if (command.length() > 0) {
+      Serial.println("Unknown command. Type 'help' for a list of commands.");
+    }
+  }
+
+  void printSystemInfo() {
+    Serial.println("System Information:");
+    Serial.print("SSID: ");
+    Serial.println(config_.ssid);
+    Serial.print("IP Address: ");
+    Serial.println(transport_.localIP());
+    Serial.print("MAC Address: ");
+    Serial.println(sensorID_);
+    Serial.print("Token Expiry Time (ms): ");
+    Serial.println(api_.tokenExpiryTime);
+  }
+
+  NodeConfig config_;
+  WebServer server_;
+  Transport transport_;
+  Clock clock_;
+  Store queue_;
+  ApiSession api_;
+  RawReporter raw_;
+  MqttReporter mqtt_;
+  OtaUpdater ota_;
+  NodeSettings settings_;
+  unsigned long lastOtaCheckMs_ = 0;
+  volatile bool otaCheckRequested_ = false; // set by the console, consumed by maintainOta()
+  PerfStats stats_;
+  uint8_t batchesSinceStats_ = 0;
+  WatchdogSupervisor wdt_;
+  bool loopTaskWatched_ = false;
+
+  // Per-dependency retry schedules (see sphinx_backoff.h).
+  Backoff linkBackoff_{1000, 60000};
+  Backoff tokenBackoff_{2000, 300000};
+  Backoff apiBackoff_{2000, 300000};
+  bool linkWasUp_ = false;
+
+  static const uint8_t kHeartbeatLedcChannel = 0;
+  static const uint8_t kHeartbeatLedcResolution = 20; // bits; allows sub-Hz blink rates
+  static const unsigned long kButtonDebounceMs = 50;
+
+  ProbeConfig probeTable_[kMaxProbes] = {};
+  DHT* probeSensors_[kMaxProbes] = {};
+  uint8_t probeCount_ = 1;
+  uint8_t currentProbe_ = 0;
+  char probeSensorIDs_[kMaxProbes][24] = {};
+  const char* probeIdPtrs_[kMaxProbes] = {};
+
+  String sensorID_;
+  QueuedReading lastReading_ = {};
+  bool hasReading_ = false;
+  QueuedReading lastQueued_[kMaxProbes] = {};
+  unsigned long lastQueuedMs_[kMaxProbes] = {};
+  bool hasQueued_[kMaxProbes] = {};
+  unsigned long startTime_ = 0;
+  unsigned long lastBatchFlushTime_ = 0;
+  bool lowPowerMode_ = false;
+  volatile bool buttonDown_ = false;
+  volatile unsigned long buttonDownSinceMs_ = 0;
+  volatile unsigned long lastButtonEdgeMs_ = 0;
+  char serialLine_[96];
+  size_t serialLineLen_ = 0;
+  uint8_t binaryBatchBuffer_[kBinaryBatchBufferSize];
+  char jsonBatchBuffer_[kJsonBatchBufferSize];
+
+  TaskHandle_t sensingTaskHandle_ = NULL;
+  TaskHandle_t networkTaskHandle_ = NULL;
+
+  Job sensingJobs_[3] = {
+      {2000, 0, &SensorNode::sampleAndQueueReading},
+      {250, 0, &SensorNode::serviceResetButton},
+      {50, 0, &SensorNode::parseSerialCommand},
+  };
+  Job networkJobs_[6] = {
+      {1000, 0, &SensorNode::maintainLink},
+      {1000, 0, &SensorNode::drainQueue},
+      {1000, 0, &SensorNode::updateClock},
+      {1000, 0, &SensorNode::maintainTokens},
+      {60000, 0, &SensorNode::maintainOta},
+      {60000, 0, &SensorNode::reportHeapStats},
+  };
+};
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "esp_http_client.h"
+#include "esp_ota_ops.h"
+#include "esp_task_wdt.h"
+
+#include "sphinx_config.h"
+#include "sphinx_net.h"
+
+// Over-the-air updates. The manifest check rides on the existing
+// authenticated session (POST {"version": ...} to the OTA endpoint,
+// answer {"version": ..., "url": ...}); the image itself is streamed in
+// 4 KB chunks from TLS straight into the inactive app partition — no RAM
+// staging, which matters with ~300 KB free.
+//
+// Rollback uses the bootloader's pending-verify state: a freshly flashed
+// image boots as PENDING_VERIFY and is only confirmed once the node has
+// shipped a batch successfully. If it cannot report within the deadline,
+// the updater rolls back to the previous image instead of leaving the
+// node limping on a bad build.
+const unsigned long kOtaReportDeadlineMs = 600000; // 10 min to first report
+const unsigned long kOtaCheckIntervalMs = 21600000; // every 6 hours
+
+class OtaUpdater {
+ public:
+  // Called after every successful batch; the first one confirms a
+  // pending image and cancels the rollback.
+  void noteReportSuccess() {
+    if (confirmed_) {
+      return;
+    }
+    confirmed_ = true;
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(running, &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+      esp_ota_mark_app_valid_cancel_rollback();
+      Serial.println("OTA: new image confirmed by first successful report");
+    }
+  }
+
+  // Watchdog for the deadline: a pending image that has not reported in
+  // time reboots into the previous one.
+  void enforceDeadline() {
+    if (confirmed_ || millis() < kOtaReportDeadlineMs) {
+      return;
+    }
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(running, &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+      Serial.println("OTA: no successful report before deadline, rolling back");
+      esp_ota_mark_app_invalid_rollback_and_reboot();
+    }
+  }
+
+  // Manifest check and, when the server offers a different version,
+  // download + install. Does not return on success — the node reboots
+  // into the new image.
+  void checkAndInstall(ApiSession& api, const char* manifestUrl) {
+    StaticJsonDocument<JSON_OBJECT_SIZE(1)> req;
+    req["version"] = kFirmwareVersion;
+    char body[64];
+    size_t bodyLen = serializeJson(req, body, sizeof(body));
+
+    int status = api.post(manifestUrl, "application/json", body, bodyLen, true, true);
+    if (status != 200) {
+      Serial.print("OTA: manifest check failed, HTTP ");
+      Serial.println(status);
+      return;
+    }
+
+    StaticJsonDocument<512> manifest;
+    if (deserializeJson(manifest, api.lastResponse())) {
+      Serial.println("OTA: manifest parse failed");
+      return;
+    }
+    const char* version = manifest["version"];
+    const char* url = manifest["url"];
+    if (version == NULL || url == NULL || strcmp(version, kFirmwareVersion) == 0) {
+      return; // up to date
+    }
+
+    Serial.print("OTA: installing ");
+    Serial.print(version);
+    Serial.print(" from ");
+    Serial.println(url);
+    if (downloadAndInstall(url, api)) {
+      Serial.println("OTA: install complete, rebooting");
+      delay(1000);
+      ESP.restart();
+    }
+  }
+
+ private:
+  bool downloadAndInstall(const char* url, ApiSession& api) {
+    esp_http_client_config_t config = {};
+    config.url = url;
+    config.cert_pem = kRootCACert;
+    config.timeout_ms = 30000;
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client == NULL) {
+      return false;
+    }
+
+    char bearer[576];
+    snprintf(bearer, sizeof(bearer), "Bearer %s", api.jwtToken.c_str());
+    esp_http_client_set_header(client, "Authorization", bearer);
+
+    bool ok = false;
+    esp_ota_handle_t ota = 0;
+    const esp_partition_t* target = esp_ota_get_next_update_partition(NULL);
+
+    do {
+      if (target == NULL || esp_http_client_open(client, 0) != ESP_OK) {
+        break;
+      }
+      esp_http_client_fetch_headers(client);
+      if (esp_http_client_get_status_code(client) != 200) {
+        Serial.print("OTA: image download failed, HTTP ");
+        Serial.println(esp_http_client_get_status_code(client));
+        break;
+      }
+      if (esp_ota_begin(target, OTA_SIZE_UNKNOWN, &ota) != ESP_OK) {
+        break;
+      }
+
+      // TLS stream -> flash, one 4 KB chunk at a time. A full image over
+      // a congested link legitimately outlasts the task WDT window, so
+      // every chunk that arrives counts as progress and feeds it.
+      static uint8_t chunk[4096];
+      int n;
+      size_t total = 0;
+      bool writeFailed = false;
+      while ((n = esp_http_client_read(client, (char*)chunk, sizeof(chunk))) > 0) {
+        esp_task_wdt_reset();
+        if (esp_ota_write(ota, chunk, n) != ESP_OK) {
+          writeFailed = true;
+          break;
+        }
+        total += n;
+      }
+      if (writeFailed || n < 0) {
+        esp_ota_abort(ota);
+        break;
+      }
+
+      if (esp_ota_end(ota) != ESP_OK) { // validates the image header/checksum
+        Serial.println("OTA: image validation failed");
+        break;
+      }
+      if (esp_ota_set_boot_partition(target) != ESP_OK) {
+        break;
+      }
+      Serial.print("OTA: wrote ");
+      Serial.print(total);
+      Serial.println(" bytes");
+      ok = true;
+    } while (false);
+
+    esp_http_client_cleanup(client);
+    return ok;
+  }
+
+  bool confirmed_ = false;
+};
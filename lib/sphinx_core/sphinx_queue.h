@@ -0,0 +1,155 @@
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#include "sphinx_config.h"
+
+// One sample as it travels through the pipeline: queued to flash, handed
+// between tasks and fed to the wire encoders. Packed plain data only.
+struct __attribute__((packed)) QueuedReading {
+  float humidity;
+  float tempC;
+  float tempF;
+  float heatIndexC;
+  float heatIndexF;
+  uint32_t uptime;
+  uint32_t epoch;  // seconds since Unix epoch
+  uint8_t probeId; // logical sub-ID of the probe that took the sample
+};
+
+// Store-and-forward queue: every reading is appended to a fixed-size ring
+// of packed records in LittleFS before any network work happens, so WiFi
+// or API outages cost nothing but flash space. The ring header is
+// persisted with each write, so queued readings survive resets and power
+// loss; when the ring wraps, the oldest reading is overwritten.
+//
+// The ring is the hand-off between the sensing and network tasks in the
+// dual-core build (push on core 0, peek/pop on core 1), so every
+// operation that touches head_/count_ or the file runs under one mutex.
+// count() stays lock-free: a single uint16_t read, and the scheduler
+// gates that consume it tolerate a one-pass-stale value.
+class FlashQueue {
+ public:
+  void begin() {
+    if (mutex_ == NULL) {
+      mutex_ = xSemaphoreCreateMutex();
+    }
+    File f = LittleFS.open(kPath, "r");
+    if (f && f.size() >= sizeof(FileHeader)) {
+      FileHeader header;
+      f.read((uint8_t*)&header, sizeof(header));
+      f.close();
+      if (header.head < kReadingQueueCapacity && header.count <= kReadingQueueCapacity) {
+        head_ = header.head;
+        count_ = header.count;
+        if (count_ > 0) {
+          Serial.print("Flash queue: ");
+          Serial.print(count_);
+          Serial.println(" reading(s) pending from before reset");
+        }
+        return;
+      }
+    }
+    if (f) {
+      f.close();
+    }
+
+    // Missing or corrupt queue file: start a fresh ring.
+    File fresh = LittleFS.open(kPath, "w");
+    FileHeader header = {0, 0};
+    fresh.write((const uint8_t*)&header, sizeof(header));
+    fresh.close();
+    head_ = 0;
+    count_ = 0;
+  }
+
+  uint16_t count() const { return count_; }
+
+  void push(const QueuedReading& reading) {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    File f = LittleFS.open(kPath, "r+");
+    if (!f) {
+      Serial.println("Flash queue: failed to open ring file");
+      xSemaphoreGive(mutex_);
+      return;
+    }
+
+    uint16_t slot = (head_ + count_) % kReadingQueueCapacity;
+    if (count_ == kReadingQueueCapacity) {
+      // Ring full: overwrite the oldest reading rather than the newest.
+      head_ = (head_ + 1) % kReadingQueueCapacity;
+    } else {
+      count_++;
+    }
+
+    f.seek(slotOffset(slot));
+    f.write((const uint8_t*)&reading, sizeof(reading));
+    writeHeader(f);
+    f.close();
+    xSemaphoreGive(mutex_);
+  }
+
+  // Reads up to `count` records starting at the ring head without popping
+  // them; returns how many were actually read.
+  uint16_t peekMany(QueuedReading* readings, uint16_t count) {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    if (count > count_) {
+      count = count_;
+    }
+    if (count == 0) {
+      xSemaphoreGive(mutex_);
+      return 0;
+    }
+    File f = LittleFS.open(kPath, "r");
+    if (!f) {
+      xSemaphoreGive(mutex_);
+      return 0;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+      uint16_t slot = (head_ + i) % kReadingQueueCapacity;
+      f.seek(slotOffset(slot));
+      f.read((uint8_t*)&readings[i], sizeof(QueuedReading));
+    }
+    f.close();
+    xSemaphoreGive(mutex_);
+    return count;
+  }
+
+  void popMany(uint16_t count) {
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    if (count > count_) {
+      count = count_;
+    }
+    head_ = (head_ + count) % kReadingQueueCapacity;
+    count_ -= count;
+    File f = LittleFS.open(kPath, "r+");
+    if (f) {
+      writeHeader(f);
+      f.close();
+    }
+    xSemaphoreGive(mutex_);
+  }
+
+ private:
+  struct __attribute__((packed)) FileHeader {
+    uint16_t head;
+    uint16_t count;
+  };
+
+  static constexpr const char* kPath = "/readings.bin";
+
+  void writeHeader(File& f) {
+    FileHeader header = {head_, count_};
+    f.seek(0);
+    f.write((const uint8_t*)&header, sizeof(header));
+  }
+
+  size_t slotOffset(uint16_t slot) const {
+    return sizeof(FileHeader) + (size_t)slot * sizeof(QueuedReading);
+  }
+
+  SemaphoreHandle_t mutex_ = NULL;
+  uint16_t head_ = 0;  // slot of the oldest unsent record
+  uint16_t count_ = 0; // number of unsent records
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <WiFiUdp.h>
+#include "mbedtls/md.h"
+
+#include "sphinx_queue.h"
+
+// Raw-socket telemetry for in-datacenter nodes, speaking the delimited
+// frame format of the Django tcp_listener command (port 1234):
+//
+//   hostname#sensor_id#temperature#humidity#error_code#hmac\n
+//
+// The trailing field is an HMAC-SHA256 (hex) over everything before it,
+// keyed from NVS; the stock listener indexes fields from the front and
+// ignores extras, so unkeyed deployments interoperate unchanged. Per
+// report this costs one socket write instead of the full TLS+JWT
+// round-trip, which is the point for nodes that share a rack with the
+// ingest host.
+enum RawTransportMode : uint8_t {
+  kRawOff = 0,
+  kRawTcp = 1,
+  kRawUdp = 2,
+};
+
+class RawReporter {
+ public:
+  // Reconfiguration comes from the serial console on the sensing task
+  // while the network task may be mid-send, so both run under one
+  // mutex; begin() also drops any connection to the previous host.
+  void begin(uint8_t mode, const String& host, uint16_t port, const String& hmacKey) {
+    if (mutex_ == NULL) {
+      mutex_ = xSemaphoreCreateMutex();
+    }
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    mode_ = mode;
+    host_ = host;
+    port_ = port;
+    hmacKey_ = hmacKey;
+    tcp_.stop();
+    xSemaphoreGive(mutex_);
+  }
+
+  bool enabled() const { return mode_ != kRawOff && host_.length() > 0; }
+
+  // One reading, one frame. The sensor ID is the caller's prebuilt
+  // per-probe wire ID (bare MAC for sub-ID 0), so a node keeps one
+  // server-side identity no matter which transport it reports over.
+  // error_code 0 means a good read; the caller only queues good reads,
+  // so that is what goes on the wire.
+  bool send(const char* hostname, const char* sensorId, const QueuedReading& reading) {
+    char frame[192];
+    int len = snprintf(frame, sizeof(frame), "%s#%s#%.2f#%.2f#0",
+                       hostname, sensorId,
+                       reading.tempC, reading.humidity);
+    if (len < 0 || (size_t)len >= sizeof(frame)) {
+      return false;
+    }
+
+    xSemaphoreTake(mutex_, portMAX_DELAY);
+    len = appendHmac(frame, len, sizeof(frame));
+    frame[len++] = '\n';
+
+    bool ok;
+    if (mode_ == kRawUdp) {
+      // Fire-and-forget: a lost datagram just means one stale sample.
+      udp_.beginPacket(host_.c_str(), port_);
+      udp_.write((const uint8_t*)frame, len);
+      ok = udp_.endPacket() == 1;
+    } else {
+      ok = sendTcp(frame, len);
+    }
+    xSemaphoreGive(mutex_);
+    return ok;
+  }
+
+ private:
+  // The listener closes the connection after each frame today, so the
+  // socket is reconnected whenever the peer has dropped it; against a
+  // streaming listener the same code keeps one connection alive.
+  bool sendTcp(const char* frame, size_t len) {
+    if (!tcp_.connected()) {
+      if (!tcp_.connect(host_.c_str(), port_, 1000)) {
+        Serial.println("Raw transport: TCP connect failed");
+        return false;
+      }
+    }
+    if (tcp_.write((const uint8_t*)frame, len) != len) {
+      tcp_.stop();
+      return false;
+    }
+    return true;
+  }
+
+  // Appends "#<hex hmac-sha256>" over the frame so far; a node without a
+  // key sends the bare five-field frame.
+  int appendHmac(char* frame, int len, size_t frameSize) {
+    if (hmacKey_.length() == 0) {
+      return len;
+    }
+    unsigned char digest[32];
+    mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                    (const unsigned char*)hmacKey_.c_str(), hmacKey_.length(),
+                    (const unsigned char*)frame, len, digest);
+    if ((size_t)len + 2 + 2 * sizeof(digest) >= frameSize) {
+      return len;
+    }
+    frame[len++] = '#';
+    for (size_t i = 0; i < sizeof(digest); i++) {
+      len += snprintf(frame + len, frameSize - len, "%02x", digest[i]);
+    }
+    return len;
+  }
+
+  SemaphoreHandle_t mutex_ = NULL;
+  uint8_t mode_ = kRawOff;
+  String host_;
+  uint16_t port_ = 1234;
+  String hmacKey_;
+  WiFiClient tcp_;
+  WiFiUDP udp_;
+};
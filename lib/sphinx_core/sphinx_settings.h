@@ -0,0 +1,184 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+#include "sphinx_config.h"
+
+// Typed configuration store on ESP32 NVS, replacing the byte-loop EEPROM
+// emulation (which burned a full 512-byte sector commit per write and
+// relied on fragile fixed offsets). Every value is cached in RAM at
+// begin(), so reads cost nothing; setters write through to NVS with
+// wear-levelled key-value updates. Values fall back to the compiled-in
+// NodeConfig when unset.
+class NodeSettings {
+ public:
+  void begin(const NodeConfig& defaults) {
+    prefs_.begin("sphinx", false);
+    ssid_ = prefs_.getString("ssid", defaults.ssid);
+    password_ = prefs_.getString("password", defaults.password);
+    lowPower_ = prefs_.getBool("lowpower", false);
+    reportIntervalMs_ = prefs_.getULong("interval", defaults.sampleIntervalMs);
+    batchSize_ = prefs_.getUShort("batch", kBatchSize);
+    if (batchSize_ < 1 || batchSize_ > kBatchSize) {
+      batchSize_ = kBatchSize; // static buffers are sized for kBatchSize
+    }
+    binaryFormat_ = prefs_.getBool("binary", false);
+    deflate_ = prefs_.getBool("deflate", false);
+    bulkEndpoint_ = prefs_.getString("endpoint", defaults.bulkApiEndpoint);
+    rawMode_ = prefs_.getUChar("rawmode", 0);
+    rawHost_ = prefs_.getString("rawhost", "");
+    rawPort_ = prefs_.getUShort("rawport", 1234);
+    rawKey_ = prefs_.getString("rawkey", "");
+    mqttUri_ = prefs_.getString("mqtturi", "");
+    otaUrl_ = prefs_.getString("otaurl", "");
+    tempDeltaC_ = prefs_.getFloat("tdelta", 0.0f);
+    humidityDelta_ = prefs_.getFloat("hdelta", 0.0f);
+    heartbeatMs_ = prefs_.getULong("hbeat", 300000);
+    prefs_.end();
+  }
+
+  const String& ssid() const { return ssid_; }
+  const String& password() const { return password_; }
+  bool lowPower() const { return lowPower_; }
+  unsigned long reportIntervalMs() const { return reportIntervalMs_; }
+  uint16_t batchSize() const { return batchSize_; }
+  bool binaryFormat() const { return binaryFormat_; }
+  bool deflate() const { return deflate_; }
+  const String& bulkEndpoint() const { return bulkEndpoint_; }
+  uint8_t rawMode() const { return rawMode_; }
+  const String& rawHost() const { return rawHost_; }
+  uint16_t rawPort() const { return rawPort_; }
+  const String& rawKey() const { return rawKey_; }
+  const String& mqttUri() const { return mqttUri_; } // empty = MQTT off
+  const String& otaUrl() const { return otaUrl_; }   // empty = OTA checks off
+
+  // Adaptive reporting: both deltas at 0 means every sample is reported;
+  // otherwise samples only go out when a value moves by at least the
+  // delta, or the heartbeat interval elapses.
+  float tempDeltaC() const { return tempDeltaC_; }
+  float humidityDelta() const { return humidityDelta_; }
+  unsigned long heartbeatMs() const { return heartbeatMs_; }
+
+  void setWiFiCredentials(const char* ssid, const char* password) {
+    ssid_ = ssid;
+    password_ = password;
+    prefs_.begin("sphinx", false);
+    prefs_.putString("ssid", ssid_);
+    prefs_.putString("password", password_);
+    prefs_.end();
+  }
+
+  void clearWiFiCredentials() {
+    ssid_ = "";
+    password_ = "";
+    prefs_.begin("sphinx", false);
+    prefs_.remove("ssid");
+    prefs_.remove("password");
+    prefs_.end();
+  }
+
+  void setLowPower(bool enabled) {
+    lowPower_ = enabled;
+    putBool("lowpower", enabled);
+  }
+
+  void setReportIntervalMs(unsigned long intervalMs) {
+    reportIntervalMs_ = intervalMs;
+    prefs_.begin("sphinx", false);
+    prefs_.putULong("interval", intervalMs);
+    prefs_.end();
+  }
+
+  void setBatchSize(uint16_t size) {
+    if (size < 1 || size > kBatchSize) {
+      Serial.print("Batch size must be 1..");
+      Serial.println(kBatchSize);
+      return;
+    }
+    batchSize_ = size;
+    prefs_.begin("sphinx", false);
+    prefs_.putUShort("batch", size);
+    prefs_.end();
+  }
+
+  void setBinaryFormat(bool enabled) {
+    binaryFormat_ = enabled;
+    putBool("binary", enabled);
+  }
+
+  void setDeflate(bool enabled) {
+    deflate_ = enabled;
+    putBool("deflate", enabled);
+  }
+
+  void setRawTransport(uint8_t mode, const char* host, uint16_t port) {
+    rawMode_ = mode;
+    rawHost_ = host;
+    rawPort_ = port;
+    prefs_.begin("sphinx", false);
+    prefs_.putUChar("rawmode", mode);
+    prefs_.putString("rawhost", rawHost_);
+    prefs_.putUShort("rawport", port);
+    prefs_.end();
+  }
+
+  void setRawKey(const char* key) {
+    rawKey_ = key;
+    prefs_.begin("sphinx", false);
+    prefs_.putString("rawkey", rawKey_);
+    prefs_.end();
+  }
+
+  void setMqttUri(const char* uri) {
+    mqttUri_ = uri;
+    prefs_.begin("sphinx", false);
+    prefs_.putString("mqtturi", mqttUri_);
+    prefs_.end();
+  }
+
+  void setOtaUrl(const char* url) {
+    otaUrl_ = url;
+    prefs_.begin("sphinx", false);
+    prefs_.putString("otaurl", otaUrl_);
+    prefs_.end();
+  }
+
+  void setAdaptiveReporting(float tempDeltaC, float humidityDelta,
+                            unsigned long heartbeatMs) {
+    tempDeltaC_ = tempDeltaC;
+    humidityDelta_ = humidityDelta;
+    heartbeatMs_ = heartbeatMs;
+    prefs_.begin("sphinx", false);
+    prefs_.putFloat("tdelta", tempDeltaC);
+    prefs_.putFloat("hdelta", humidityDelta);
+    prefs_.putULong("hbeat", heartbeatMs);
+    prefs_.end();
+  }
+
+ private:
+  void putBool(const char* key, bool value) {
+    prefs_.begin("sphinx", false);
+    prefs_.putBool(key, value);
+    prefs_.end();
+  }
+
+  Preferences prefs_;
+  String ssid_;
+  String password_;
+  String bulkEndpoint_;
+  bool lowPower_ = false;
+  unsigned long reportIntervalMs_ = 2000;
+  uint16_t batchSize_ = kBatchSize;
+  bool binaryFormat_ = false;
+  bool deflate_ = false;
+  uint8_t rawMode_ = 0;
+  String rawHost_;
+  uint16_t rawPort_ = 1234;
+  String rawKey_;
+  String mqttUri_;
+  String otaUrl_;
+  float tempDeltaC_ = 0.0f;
+  float humidityDelta_ = 0.0f;
+  unsigned long heartbeatMs_ = 300000;
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "esp_heap_caps.h"
+
+// Cycle-accurate timing of the hot loop phases, cheap enough to stay on
+// in production: each phase costs two reads of the CPU cycle counter
+// (ESP.getCycleCount()) and a handful of integer ops. Durations are
+// accumulated as min/avg/max per rolling window and converted to
+// microseconds only on output. The counter wraps every ~18 s at
+// 240 MHz; the unsigned subtraction keeps any phase shorter than that
+// correct across the wrap.
+enum StatsPhase : uint8_t {
+  kPhaseDhtRead = 0,
+  kPhaseSend,
+  kPhaseTokenRefresh,
+  kPhaseWebServer,
+  kPhaseCount,
+};
+
+static const char* const kPhaseNames[kPhaseCount] = {"dht", "send", "refresh", "web"};
+
+// Every Nth JSON batch carries the rolled-up window, so fleet-wide
+// phase regressions land in the ingest pipeline instead of needing a
+// serial cable on a ladder.
+const uint8_t kStatsEveryNthBatch = 10;
+
+// Phases are recorded from both pinned tasks in the dual-core build
+// (dht/web on core 0, send/refresh on core 1), so every touch of the
+// accumulators runs inside a cross-core spinlock — the critical
+// sections are a few integer ops or one memcpy, which is what portMUX
+// is for. Readers snapshot the window under the lock and format
+// outside it.
+class PerfStats {
+ public:
+  static uint32_t now() { return ESP.getCycleCount(); }
+
+  // Closes a phase opened with now().
+  void record(uint8_t phase, uint32_t startCycles) {
+    uint32_t cycles = ESP.getCycleCount() - startCycles;
+    portENTER_CRITICAL(&mux_);
+    Phase& p = phases_[phase];
+    if (p.count == 0 || cycles < p.minCycles) {
+      p.minCycles = cycles;
+    }
+    if (cycles > p.maxCycles) {
+      p.maxCycles = cycles;
+    }
+    p.sumCycles += cycles;
+    p.count++;
+    portEXIT_CRITICAL(&mux_);
+  }
+
+  // Serializes the current window as one JSON object (per-phase
+  // min/avg/max in µs plus the heap counters) and starts a new window.
+  size_t writeJson(char* out, size_t outSize) {
+    Phase snapshot[kPhaseCount];
+    portENTER_CRITICAL(&mux_);
+    memcpy(snapshot, phases_, sizeof(phases_));
+    memset(phases_, 0, sizeof(phases_));
+    portEXIT_CRITICAL(&mux_);
+
+    StaticJsonDocument<JSON_OBJECT_SIZE(kPhaseCount + 2) +
+                       kPhaseCount * JSON_OBJECT_SIZE(4)> doc;
+    uint32_t cyclesPerUs = ESP.getCpuFreqMHz();
+    for (uint8_t i = 0; i < kPhaseCount; i++) {
+      const Phase& p = snapshot[i];
+      if (p.count == 0) {
+        continue;
+      }
+      JsonObject o = doc.createNestedObject(kPhaseNames[i]);
+      o["min_us"] = p.minCycles / cyclesPerUs;
+      o["avg_us"] = (uint32_t)(p.sumCycles / p.count) / cyclesPerUs;
+      o["max_us"] = p.maxCycles / cyclesPerUs;
+      o["n"] = p.count;
+    }
+    doc["heap_free"] = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    doc["heap_max_block"] = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+    return serializeJson(doc, out, outSize);
+  }
+
+  // Serial-console dump of the current window; does not reset it.
+  void printTo(Stream& out) {
+    Phase snapshot[kPhaseCount];
+    portENTER_CRITICAL(&mux_);
+    memcpy(snapshot, phases_, sizeof(phases_));
+    portEXIT_CRITICAL(&mux_);
+
+    uint32_t cyclesPerUs = ESP.getCpuFreqMHz();
+    out.println("Phase timings (us, current window):");
+    for (uint8_t i = 0; i < kPhaseCount; i++) {
+      const Phase& p = snapshot[i];
+      out.print("  ");
+      out.print(kPhaseNames[i]);
+      if (p.count == 0) {
+        out.println(": no samples");
+        continue;
+      }
+      out.print(": min ");
+      out.print(p.minCycles / cyclesPerUs);
+      out.print(" avg ");
+      out.print((uint32_t)(p.sumCycles / p.count) / cyclesPerUs);
+      out.print(" max ");
+      out.print(p.maxCycles / cyclesPerUs);
+      out.print(" n ");
+      out.println(p.count);
+    }
+  }
+
+  void reset() {
+    portENTER_CRITICAL(&mux_);
+    memset(phases_, 0, sizeof(phases_));
+    portEXIT_CRITICAL(&mux_);
+  }
+
+ private:
+  struct Phase {
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t sumCycles;
+    uint32_t count;
+  };
+
+  portMUX_TYPE mux_ = portMUX_INITIALIZER_UNLOCKED;
+  Phase phases_[kPhaseCount] = {};
+};
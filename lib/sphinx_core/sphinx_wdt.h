@@ -0,0 +1,132 @@
+#pragma once
+
+#include <Arduino.h>
+#include <string.h>
+#include "esp_task_wdt.h"
+#include "esp_debug_helpers.h"
+
+// Task-level watchdog supervision with crash forensics. A wedged node —
+// typically stuck inside the blocking HTTP stack or a reconnect loop —
+// used to sit dead until someone noticed the server-side staleness alert
+// and power-cycled it. Registering every scheduler task with the ESP
+// task WDT turns that into an automatic reboot, and the ISR hook below
+// records who wedged, where, and the last perf window into RTC noinit
+// RAM (which survives any reset except power loss) so the first report
+// after recovery carries the evidence.
+
+// Must exceed the 10 s HTTP client timeout plus a TLS handshake, since a
+// single legitimate POST holds the network task for that long without a
+// feed. Multi-batch drains feed between batches.
+static const uint32_t kWdtTimeoutSec = 15;
+
+static const uint32_t kCrashRecordMagic = 0x57444721; // 'WDG!'
+static const uint8_t kCrashBacktraceDepth = 8;
+
+struct CrashRecord {
+  uint32_t magic; // kCrashRecordMagic when the rest is valid
+  char taskName[16];
+  uint32_t uptimeMs;
+  uint8_t backtraceLen;
+  uint32_t backtrace[kCrashBacktraceDepth]; // PC chain, innermost first
+  // Sized like sendBatch's statsBuffer: a steady-state window with all
+  // four phases active runs ~300 bytes minified, and a truncated copy
+  // here would poison the report payload it gets spliced into.
+  char statsJson[512];
+};
+
+// Deliberately noinit: survives the reboot that follows the panic. The
+// magic field distinguishes a real record from power-on garbage.
+RTC_NOINIT_ATTR CrashRecord rtcCrashRecord;
+
+// Refreshed by the node whenever it rolls up a perf window; the ISR only
+// copies it, it never formats anything.
+static char gWdtStatsSnapshot[512];
+
+// Called from the WDT ISR on the core whose task stopped feeding, before
+// the watchdog's own panic reboots the chip. The interrupted frame *is*
+// the wedged code, so walking the stack from here yields the backtrace
+// we want.
+extern "C" void esp_task_wdt_isr_user_handler(void) {
+  CrashRecord& rec = rtcCrashRecord;
+  strncpy(rec.taskName, pcTaskGetName(NULL), sizeof(rec.taskName) - 1);
+  rec.taskName[sizeof(rec.taskName) - 1] = '\0';
+  rec.uptimeMs = millis();
+
+  esp_backtrace_frame_t frame;
+  esp_backtrace_get_start(&frame.pc, &frame.sp, &frame.next_pc);
+  rec.backtraceLen = 0;
+  while (rec.backtraceLen < kCrashBacktraceDepth) {
+    rec.backtrace[rec.backtraceLen++] = frame.pc;
+    if (!esp_backtrace_get_next_frame(&frame)) {
+      break;
+    }
+  }
+
+  memcpy(rec.statsJson, gWdtStatsSnapshot, sizeof(rec.statsJson));
+  rec.statsJson[sizeof(rec.statsJson) - 1] = '\0';
+  rec.magic = kCrashRecordMagic;
+}
+
+class WatchdogSupervisor {
+ public:
+  // panic=true: the WDT reboots through the panic handler after the ISR
+  // hook above has written the record.
+  void begin() { esp_task_wdt_init(kWdtTimeoutSec, true); }
+
+  // Each supervised loop registers itself once and feeds every pass.
+  void watchCurrentTask() { esp_task_wdt_add(NULL); }
+  void feed() { esp_task_wdt_reset(); }
+
+  bool crashPending() const { return rtcCrashRecord.magic == kCrashRecordMagic; }
+
+  // Serializes the pending record as a JSON object for the report
+  // piggyback. Addresses go out raw; they resolve against the matching
+  // ELF with addr2line. The stats snapshot is spliced in verbatim, so it
+  // only rides along when it is a complete object — anything truncated
+  // or garbled would invalidate the whole batch payload and leave the
+  // node unable to report at all.
+  size_t writeCrashJson(char* out, size_t outSize) const {
+    const CrashRecord& rec = rtcCrashRecord;
+    size_t n = snprintf(out, outSize,
+                        "{\"crash\":{\"task\":\"%s\",\"uptime_ms\":%lu,\"bt\":[",
+                        rec.taskName, (unsigned long)rec.uptimeMs);
+    for (uint8_t i = 0; i < rec.backtraceLen && n < outSize; i++) {
+      n += snprintf(out + n, outSize - n, "%s\"0x%08lx\"", i ? "," : "",
+                    (unsigned long)rec.backtrace[i]);
+    }
+    if (n < outSize) {
+      size_t statsLen = strnlen(rec.statsJson, sizeof(rec.statsJson));
+      bool statsComplete = statsLen >= 2 && statsLen < sizeof(rec.statsJson) &&
+                           rec.statsJson[0] == '{' &&
+                           rec.statsJson[statsLen - 1] == '}' &&
+                           n + statsLen + 16 < outSize; // "],\"stats\":" + "}}" must fit too
+      n += snprintf(out + n, outSize - n, "],\"stats\":%s}}",
+                    statsComplete ? rec.statsJson : "null");
+    }
+    return n < outSize ? n : outSize - 1;
+  }
+
+  // Called once the record has been delivered (or printed) so the next
+  // boot doesn't re-report it.
+  void clearCrash() { rtcCrashRecord.magic = 0; }
+
+  // Keeps the ISR-visible snapshot current; called wherever the node
+  // rolls up a perf window anyway.
+  static void noteStats(const char* json) {
+    strncpy(gWdtStatsSnapshot, json, sizeof(gWdtStatsSnapshot) - 1);
+    gWdtStatsSnapshot[sizeof(gWdtStatsSnapshot) - 1] = '\0';
+  }
+
+  void printCrash(Stream& out) const {
+    const CrashRecord& rec = rtcCrashRecord;
+    out.print("Watchdog reboot: task '");
+    out.print(rec.taskName);
+    out.print("' wedged at uptime ");
+    out.print(rec.uptimeMs);
+    out.println(" ms. Backtrace:");
+    for (uint8_t i = 0; i < rec.backtraceLen; i++) {
+      out.print("  0x");
+      out.println(rec.backtrace[i], HEX);
+    }
+  }
+};
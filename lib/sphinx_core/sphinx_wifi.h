@@ -0,0 +1,139 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+
+#include "sphinx_config.h"
+
+// WiFi transport for SensorNode. Carries the fast-reconnect cache: the
+// BSSID, channel and IP lease of the last successful association are kept
+// in NVS so a reboot can skip the full scan and DHCP exchange. A directed
+// connect with the cached parameters is tried first; full scan + DHCP is
+// the fallback. begin() makes one bounded attempt and returns — ongoing
+// recovery belongs to the node's link job, which calls kickReconnect()
+// on its own backoff schedule instead of this class blocking forever.
+class WiFiTransport {
+ public:
+  void begin(const NodeConfig& config) {
+    config_ = &config;
+
+    Serial.print("Connecting to WiFi ");
+    Serial.println(config.ssid);
+
+    if (!tryCachedConnect()) {
+      WiFi.begin(config.ssid, config.password);
+      if (!waitForConnect(10000)) {
+        Serial.println("");
+        Serial.println("WiFi not up yet; the link job keeps retrying in the background");
+        return;
+      }
+    }
+
+    saveCache();
+
+    Serial.println("");
+    Serial.println("WiFi connected.");
+    Serial.println("IP address: ");
+    Serial.println(WiFi.localIP());
+  }
+
+  // Non-blocking reconnect kick for the link job: starts a fresh
+  // association attempt and returns; connected() reports the outcome on
+  // later passes.
+  void kickReconnect() {
+    WiFi.disconnect();
+    WiFi.begin(config_->ssid, config_->password);
+  }
+
+  // Called by the link job once the link is back, so the fast-reconnect
+  // cache follows AP changes.
+  void noteConnected() { saveCache(); }
+
+  // Bounded connect for the deep-sleep path: on battery we'd rather skip
+  // one upload window than spin on a down AP.
+  bool beginBounded(const NodeConfig& config, unsigned long timeoutMs) {
+    config_ = &config;
+    Serial.print("Connecting to WiFi ");
+    Serial.println(config.ssid);
+    WiFi.begin(config.ssid, config.password);
+    bool ok = waitForConnect(timeoutMs);
+    Serial.println("");
+    if (ok) {
+      saveCache();
+    }
+    return ok;
+  }
+
+  bool connected() const { return WiFi.status() == WL_CONNECTED; }
+
+  String macAddress() const { return WiFi.macAddress(); }
+
+  void macAddressBytes(uint8_t out[6]) const { WiFi.macAddress(out); }
+
+  IPAddress localIP() const { return WiFi.localIP(); }
+
+  void powerOff() { WiFi.disconnect(true); }
+
+ private:
+  bool waitForConnect(unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (WiFi.status() != WL_CONNECTED) {
+      if (millis() - start >= timeoutMs) {
+        return false;
+      }
+      delay(250);
+      Serial.print(".");
+    }
+    return true;
+  }
+
+  void saveCache() {
+    cache_.begin("wificache", false);
+    cache_.putBytes("bssid", WiFi.BSSID(), 6);
+    cache_.putInt("channel", WiFi.channel());
+    cache_.putUInt("ip", (uint32_t)WiFi.localIP());
+    cache_.putUInt("gateway", (uint32_t)WiFi.gatewayIP());
+    cache_.putUInt("subnet", (uint32_t)WiFi.subnetMask());
+    cache_.putUInt("dns", (uint32_t)WiFi.dnsIP());
+    cache_.putUChar("valid", 1);
+    cache_.end();
+  }
+
+  bool tryCachedConnect() {
+    cache_.begin("wificache", true);
+    bool haveCache = cache_.getUChar("valid", 0) == 1;
+    uint8_t bssid[6];
+    int32_t channel = 0;
+    IPAddress ip, gateway, subnet, dns;
+    if (haveCache) {
+      cache_.getBytes("bssid", bssid, sizeof(bssid));
+      channel = cache_.getInt("channel", 0);
+      ip = IPAddress(cache_.getUInt("ip", 0));
+      gateway = IPAddress(cache_.getUInt("gateway", 0));
+      subnet = IPAddress(cache_.getUInt("subnet", 0));
+      dns = IPAddress(cache_.getUInt("dns", 0));
+    }
+    cache_.end();
+
+    if (!haveCache || channel == 0 || (uint32_t)ip == 0) {
+      return false;
+    }
+
+    Serial.println("Trying cached BSSID/channel with static lease");
+    WiFi.config(ip, gateway, subnet, dns);
+    WiFi.begin(config_->ssid, config_->password, channel, bssid);
+    if (waitForConnect(3000)) {
+      return true;
+    }
+
+    // Cache is stale (AP moved channel, lease changed): drop back to DHCP
+    // and a full scan.
+    WiFi.disconnect(true);
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    return false;
+  }
+
+  const NodeConfig* config_ = NULL;
+  Preferences cache_;
+};
@@ -1 +1,46 @@
-a
\ No newline at end of file
+#include <sphinx_core.h>
+#include <sphinx_eth.h>
+
+// Rack-mounted wired variant: ESP32 with a LAN8720 PHY over RMII and a
+// DHT22 on GPIO4. Same reporting pipeline as the WiFi builds but with
+// sub-10 ms RTTs to the ingest and no scan/DHCP stall on boot; the WiFi
+// stack is never linked, which frees RAM for bigger batch buffers.
+//
+// RMII claims GPIO19/21/22/25/26/27 plus GPIO0 (clock in), MDC on 23 and
+// MDIO on 18, so the DHT22, LED and button stay clear of those.
+NodeConfig nodeConfig = {
+  .ssid = "",      // unused on wired transport
+  .password = "",
+
+  .apiEndpoint = "https://windevs.uz/sensors/api/sensor-data/",
+  .bulkApiEndpoint = "https://windevs.uz/sensors/api/sensor-data/bulk/",
+  .tokenEndpoint = "https://windevs.uz/sensors/api/token/",
+  .refreshEndpoint = "https://windevs.uz/sensors/api/token/refresh/",
+
+  .basicAuthUsername = "admin",
+  .basicAuthPassword = "admin",
+
+  .apiUsername = "admin",
+  .apiPassword = "admin",
+
+  .dhtPin = 4,
+  .dhtType = DHT22,
+  .ledPin = 2,
+  .resetButtonPin = 5,
+
+  .serialBaud = 115200,
+  .sampleIntervalMs = 2000,
+
+  .lowPowerWakeIntervalSec = 60,
+  .uploadEveryNthWake = 10,
+};
+
+SensorNode<EthTransport> node(nodeConfig);
+
+void setup() {
+  node.begin();
+}
+
+void loop() {
+  node.tick();
+}
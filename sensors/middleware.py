@@ -0,0 +1,38 @@
+import io
+import logging
+import zlib
+
+from django.http import HttpResponse
+
+logger = logging.getLogger(__name__)
+
+
+class DeflateRequestMiddleware:
+    """Inflates request bodies sent with Content-Encoding: deflate.
+
+    Firmware nodes compress batch uploads through the ESP32's ROM copy of
+    miniz, which emits a zlib-wrapped stream; some clients send raw
+    deflate instead, so both framings are accepted. A body that fails to
+    inflate gets a 415, which the node treats as a signal to fall back to
+    identity encoding and resend.
+    """
+
+    def __init__(self, get_response):
+        self.get_response = get_response
+
+    def __call__(self, request):
+        if request.META.get('HTTP_CONTENT_ENCODING', '').lower() == 'deflate':
+            try:
+                body = zlib.decompress(request.body)
+            except zlib.error:
+                try:
+                    body = zlib.decompress(request.body, -zlib.MAX_WBITS)
+                except zlib.error:
+                    logger.warning('Undecodable deflate body from %s',
+                                   request.META.get('REMOTE_ADDR'))
+                    return HttpResponse(status=415)
+            request._body = body
+            request._stream = io.BytesIO(body)
+            request.META['CONTENT_LENGTH'] = str(len(body))
+            del request.META['HTTP_CONTENT_ENCODING']
+        return self.get_response(request)
@@ -1,9 +1,25 @@
+import datetime
+
 from rest_framework import serializers
 from .models import SensorData
 
+
+class EpochDateTimeField(serializers.DateTimeField):
+    """Accepts Unix epoch seconds (what the firmware's extrapolated clock
+    emits) in addition to the usual datetime string formats."""
+
+    def to_internal_value(self, value):
+        if isinstance(value, (int, float)) or (isinstance(value, str) and value.isdigit()):
+            return datetime.datetime.fromtimestamp(int(value), tz=datetime.timezone.utc)
+        return super().to_internal_value(value)
+
+
 class SensorDataSerializer(serializers.ModelSerializer):
     uptime = serializers.FloatField(write_only=True)
     uptime_hours = serializers.SerializerMethodField(read_only=True)
+    # required=False preserves the model-derived contract: the field has
+    # default=timezone.now, so clients that omit it stay valid.
+    datetime = EpochDateTimeField(required=False)
 
     class Meta:
         model = SensorData
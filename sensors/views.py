@@ -1,5 +1,9 @@
+import datetime
+import logging
+import struct
+
 from django.shortcuts import render
-from rest_framework import generics, permissions, status
+from rest_framework import generics, parsers, permissions, status
 from rest_framework_simplejwt.views import TokenObtainPairView
 from .models import SensorData
 from rest_framework.response import Response
@@ -8,6 +12,8 @@ from .serializers import SensorDataSerializer
 from rest_framework_simplejwt.authentication import JWTAuthentication
 
 
+logger = logging.getLogger(__name__)
+
 
 class SensorDataView(generics.ListCreateAPIView):
     queryset = SensorData.objects.all()
@@ -43,6 +49,103 @@ class SensorDataView(generics.ListCreateAPIView):
         return Response(serializer.errors, status=status.HTTP_400_BAD_REQUEST)
 
 
+class BinarySensorPayloadParser(parsers.BaseParser):
+    """Passes the packed binary batch format from the firmware through as raw
+    bytes; decoding happens in the view."""
+
+    media_type = 'application/x-sphinx-sensor-v1'
+
+    def parse(self, stream, media_type=None, parser_context=None):
+        return stream.read()
+
+
+class SensorDataBulkView(SensorDataView):
+    """Accepts a JSON array of readings in one request so firmware can batch
+    samples instead of POSTing each one individually. Also accepts the
+    firmware's packed binary batch format: a 4-byte header followed by
+    little-endian samples — version 1 carries 20-byte samples, version 2
+    adds a probe sub-ID byte (22 bytes) for multi-probe nodes, reported as
+    '<MAC>-<probe>' with probe 0 staying the bare MAC."""
+
+    parser_classes = [parsers.JSONParser, BinarySensorPayloadParser]
+
+    BINARY_HEADER = struct.Struct('<BBH')
+    BINARY_SAMPLE_V1 = struct.Struct('<6sIhhhI')
+    BINARY_SAMPLE_V2 = struct.Struct('<6sBBIhhhI')
+
+    def decode_binary_batch(self, payload):
+        version, _, count = self.BINARY_HEADER.unpack_from(payload, 0)
+        if version == 1:
+            sample_struct = self.BINARY_SAMPLE_V1
+        elif version == 2:
+            sample_struct = self.BINARY_SAMPLE_V2
+        else:
+            raise ValueError(f'Unsupported binary batch version {version}')
+        expected = self.BINARY_HEADER.size + count * sample_struct.size
+        if len(payload) != expected:
+            raise ValueError(f'Binary batch length {len(payload)} != expected {expected}')
+
+        readings = []
+        for i in range(count):
+            offset = self.BINARY_HEADER.size + i * sample_struct.size
+            if version == 1:
+                mac, epoch, temperature, humidity, heat_index, uptime = \
+                    sample_struct.unpack_from(payload, offset)
+                probe = 0
+            else:
+                mac, probe, _, epoch, temperature, humidity, heat_index, uptime = \
+                    sample_struct.unpack_from(payload, offset)
+            sensor_id = ':'.join(f'{b:02X}' for b in mac)
+            if probe:
+                sensor_id = f'{sensor_id}-{probe}'
+            readings.append({
+                'sensor_id': sensor_id,
+                'temperature': temperature / 100,
+                'humidity': humidity / 100,
+                'heat_index': heat_index / 100,
+                'uptime': uptime,
+                'datetime': datetime.datetime.fromtimestamp(epoch, tz=datetime.timezone.utc),
+            })
+        return readings
+
+    def create(self, request, *args, **kwargs):
+        if isinstance(request.data, bytes):
+            try:
+                data = self.decode_binary_batch(request.data)
+            except (ValueError, struct.error) as e:
+                return Response({'detail': str(e)}, status=status.HTTP_400_BAD_REQUEST)
+        else:
+            data = request.data
+
+        if not isinstance(data, list):
+            return Response({'detail': 'Expected a JSON array of readings.'}, status=status.HTTP_400_BAD_REQUEST)
+
+        saved = 0
+        errors = []
+        for item in data:
+            # Firmware piggybacks a perf-stats object onto every Nth batch;
+            # log it so fleet-wide regressions are greppable server-side.
+            if isinstance(item, dict) and 'stats' in item:
+                stats = item.pop('stats')
+                if isinstance(stats, dict) and 'crash' in stats:
+                    # First report after a watchdog reboot carries the crash
+                    # record (wedged task, backtrace, last perf window).
+                    logger.warning('Node crash record from %s: %s',
+                                   item.get('sensor_id'), stats['crash'])
+                else:
+                    logger.info('Node perf stats from %s: %s', item.get('sensor_id'), stats)
+            serializer = self.serializer_class(data=item)
+            if serializer.is_valid():
+                self.perform_create(serializer)
+                saved += 1
+            else:
+                errors.append(serializer.errors)
+
+        if errors and not saved:
+            return Response(errors, status=status.HTTP_400_BAD_REQUEST)
+        return Response({'saved': saved, 'errors': errors}, status=status.HTTP_201_CREATED)
+
+
 class CustomTokenObtainPairView(TokenObtainPairView):
     pass
 